@@ -5,7 +5,7 @@
 #include "fpint.h"
 #include "battery.h"
 #include "solarpanel.h"
-#include "energymeter.h"
+#include "energyledger.h"
 
 #define DEBUG DEBUG_OFF
 #include "debug.h"
@@ -21,47 +21,99 @@ static fpint fp_capacity;
 static fpint fp_drain_day = 0;
 
 /**
- * information when battery was last updated for specific energy drain sources
+ * position in energy ledger when battery was last updated
  */
-static energymeter_sample lastsample = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
+static energyledger_cursor cursor;
 
 /**
- * process for periodically battery updates
+ * last day of battery drain calculation
  */
-PROCESS(battery_process, "Battery-Process");
+static int drain_last_day = TIME_DAY;
+
+#if SOLARPANEL_EMULATE
+
+/**
+ * harvested solar energy of the actual day
+ */
+static fpint fp_solarenergy_day = 0;
 
 /**
- * process for periodically energy harvesting with solar panel
+ * day of harvested solar energy
  */
-PROCESS(solarpanel_process, "Solarpanel-Process");
+static int solarenergy_last_day = TIME_DAY;
+
+/**
+ * harvested solar energy not yet added to battery capacity
+ */
+static fpint fp_solarenergy_pending = 0;
+
+/**
+ * saves energy harvested by solar panel for next update of battery
+ */
+static void solarpanel_harvested(fpint fp_additional_capacity) {
+	// a new day begins...
+	if(solarenergy_last_day != time_day()) {
+		debug("[SOLARPANEL] harvested %smAh\n", debug_fpint(fp_solarenergy_day));
+		fp_solarenergy_day = 0;
+		solarenergy_last_day = time_day();
+	}
+
+	// added to battery when it is read (reading would update energyledger on every harvest)
+	fp_solarenergy_pending = fpint_add(fp_solarenergy_pending, fp_additional_capacity);
+
+	// add to cummulated
+	fp_solarenergy_day = fpint_add(fp_solarenergy_day, fp_additional_capacity);
+}
+
+/**
+ * subscription to solar panel harvest
+ */
+static solarpanel_subscriber solarpanel = { NULL, &solarpanel_harvested };
+
+#endif
 
 /**
  * helper function for updating the battery
+ *
+ * (battery is updated only when read, drain since last read is taken from energy ledger
+ * and energy harvested since last read is added up to the maximum capacity)
  */
 static fpint update_battery() {
-    // get sample
-    static energymeter_sample sample;
-    energymeter_sampling(&sample);
-
-    // calculate drain
-    fpint fp_drain = energymeter_calculate_drain_update_last(&lastsample, &sample, ENERGYMETER_DRAIN_ONLY_FULL_TIMEFRAMES);
+    // calculate debug day drainage
+    if(drain_last_day != time_day()) {
+        debug("[BATTERY] %smAh drain\n", debug_fpint(fp_drain_day));
+        fp_drain_day = 0;
+        drain_last_day = time_day();
+    }
+
+    // drain since last update
+    fpint fp_drain = energyledger_drain(&cursor, ENERGYLEDGER_ALL);
+    energyledger_cursor_advance(&cursor);
     fp_drain_day   = fpint_add(fp_drain_day, fp_drain);
 
     // update battery
-    return fp_capacity = fpint_max(fpint_to(0), fpint_sub(fp_capacity, fp_drain));
+    fp_capacity = fpint_max(fpint_to(0), fpint_sub(fp_capacity, fp_drain));
+	#if SOLARPANEL_EMULATE
+		fp_capacity = fpint_min(battery_maxcapacity(), fpint_add(fp_capacity, fp_solarenergy_pending));
+		fp_solarenergy_pending = 0;
+	#endif
+
+    return fp_capacity;
 }
 
 void battery_init() {
     #if BATTERY_EMULATE
-        process_start(&battery_process, NULL);
+        // set battery to initial capacity
+        fpint fp_load = fpint_div(fpint_to(BATTERY_INITIALCAPACITY), fpint_to(100));
+        fp_capacity = fpint_mul(battery_maxcapacity(), fp_load);
     #endif
 	#if SOLARPANEL_EMULATE
-		process_start(&solarpanel_process, NULL);
+		solarpanel_subscribe(&solarpanel);
 	#endif
 }
 
 int battery_level() {
-	fpint fp_percent = fpint_div(fpint_mul(battery_capacity(), fpint_to(100)), battery_maxcapacity());
+	fpint fp_percent = fpint_mul(fpint_div(battery_capacity(), battery_maxcapacity()), fpint_to(100));
     return fpint_from(fp_percent);
 }
 
@@ -81,92 +133,3 @@ fpint battery_maxcapacity() {
         #error no real battery implemented
     #endif
 }
-
-/**
- * updates periodically the battery capacity
- */
-PROCESS_THREAD(battery_process, ev, data) {
-	PROCESS_BEGIN();
-
-	// set battery to initial capacity
-	fpint fp_load = fpint_div(fpint_to(BATTERY_INITIALCAPACITY), fpint_to(100));
-	fp_capacity = fpint_mul(battery_maxcapacity(), fp_load);
-
-	// timer for updating the battery periodically
-	static struct etimer timer_update_battery;
-	etimer_set(&timer_update_battery, CLOCK_SECOND * 300 / SPEEDMULTIPLIER); // every 5 minutes
-
-	// last day of battery calculation
-	static int last_day = TIME_DAY;
-
-	// update loop
-	while(1) {
-		PROCESS_WAIT_UNTIL(etimer_expired(&timer_update_battery));
-
-		// update battery
-		update_battery();
-
-		// calculate debug day drainage
-		if(last_day != time_day()) {
-			debug("[BATTERY] %smAh drain\n", debug_fpint(fp_drain_day));
-			fp_drain_day = 0;
-			last_day = time_day();
-		}
-
-		// restart timer
-		etimer_reset(&timer_update_battery);
-	}
-
-	PROCESS_END();
-}
-
-/**
- *
- *
- * Solarpanel implementation
- *
- *
- */
-
-/**
- * updates periodically the battery capacity with enegergy harvested by solar panel
- */
-PROCESS_THREAD(solarpanel_process, ev, data) {
-	PROCESS_BEGIN();
-
-	// timer for updating  solar calculation periodically
-	static struct etimer timer_update_solar;
-	etimer_set(&timer_update_solar, CLOCK_SECOND * 60 / SPEEDMULTIPLIER);
-
-	// cummulated solar energy of complete day
-	static fpint fp_solarenergy_day = 0;
-
-	// last day of battery calculation
-	static int last_day = TIME_DAY;
-
-	// update loop
-	while(1) {
-		PROCESS_WAIT_UNTIL(etimer_expired(&timer_update_solar));
-
-		// a new day begins...
-		if(last_day != time_day()) {
-			debug("[SOLARPANEL] harvested %smAh\n", debug_fpint(fp_solarenergy_day));
-			fp_solarenergy_day = 0;
-			last_day = time_day();
-		}
-
-		// calculate energy flow
-		fpint fp_additional_capacity = solarpanel_capacity(60);
-
-		// update battery
-		fp_capacity = fpint_min(battery_maxcapacity(), fpint_add(fp_additional_capacity, battery_capacity()));
-
-		// add to cummulated
-		fp_solarenergy_day = fpint_add(fp_solarenergy_day, fp_additional_capacity);
-
-		// restart timer
-		etimer_reset(&timer_update_solar);
-	}
-
-	PROCESS_END();
-}
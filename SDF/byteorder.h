@@ -0,0 +1,30 @@
+#ifndef BYTEORDER_H_
+#define BYTEORDER_H_
+
+#include <stdint.h>
+
+/**
+ * writing and reading values of binary messages
+ *
+ * values are little endian (byte order of msp430) and byte aligned
+ */
+static inline uint8_t* byteorder_put16(uint8_t* buffer, uint16_t value) {
+	buffer[0] = value;
+	buffer[1] = value >> 8;
+	return buffer + 2;
+}
+
+static inline uint8_t* byteorder_put32(uint8_t* buffer, uint32_t value) {
+	buffer = byteorder_put16(buffer, value);
+	return byteorder_put16(buffer, value >> 16);
+}
+
+static inline uint16_t byteorder_get16(const uint8_t* buffer) {
+	return buffer[0] | ((uint16_t) buffer[1] << 8);
+}
+
+static inline uint32_t byteorder_get32(const uint8_t* buffer) {
+	return byteorder_get16(buffer) | ((uint32_t) byteorder_get16(buffer + 2) << 16);
+}
+
+#endif /* BYTEORDER_H_ */
@@ -1,13 +1,140 @@
+#include <string.h>
+
 #include "circularbuffer.h"
+#include "gccbugs.h"
 #include "fpint.h"
 
-void circularbuffer_save(fpint* samples, int size, fpint sample, int* nextpos, int* saved) {
-	samples[*nextpos] = sample;
+/**
+ * address of element at storage index
+ */
+static void* element_at(const struct circularbuffer* buffer, unsigned short index) {
+	return (char*) buffer->elements + index * buffer->element_size;
+}
+
+void circularbuffer_clear(struct circularbuffer* buffer) {
+	buffer->nextpos = 0;
+	buffer->saved   = 0;
+}
+
+void* circularbuffer_save(struct circularbuffer* buffer, const void* element) {
+	void* saved = element_at(buffer, buffer->nextpos);
+	memcpy(saved, element, buffer->element_size);
 
 	// increment saved variable but stop at maximum size of circular buffer
-	if(++*saved > size)
-		*saved = size;
+	if(buffer->saved < buffer->size)
+		buffer->saved++;
 
 	// increment nextpos and wrap at size of circular buffer
-	*nextpos = ++*nextpos % size;
+	if(++buffer->nextpos == buffer->size)
+		buffer->nextpos = 0;
+
+	return saved;
+}
+
+void* circularbuffer_get(const struct circularbuffer* buffer, unsigned short pos) {
+	if(pos >= buffer->saved)
+		return NULL;
+
+	// oldest element is saved elements before nextpos (without modulo operation)
+	unsigned short index = buffer->nextpos + pos;
+	if(index < buffer->saved)
+		index += buffer->size;
+	index -= buffer->saved;
+	if(index >= buffer->size)
+		index -= buffer->size;
+
+	return element_at(buffer, index);
+}
+
+void* circularbuffer_peek(const struct circularbuffer* buffer) {
+	return circularbuffer_get(buffer, 0);
+}
+
+int circularbuffer_drain(struct circularbuffer* buffer, void* element) {
+	void* oldest = circularbuffer_peek(buffer);
+	if(oldest == NULL)
+		return 0;
+
+	if(element != NULL)
+		memcpy(element, oldest, buffer->element_size);
+	buffer->saved--;
+
+	return 1;
+}
+
+void circularbuffer_stats_clear(circularbuffer_stats* stats) {
+	circularbuffer_clear(&stats->buffer);
+	stats->sum         = 0;
+	stats->sum_squares = 0;
+}
+
+void circularbuffer_stats_save(circularbuffer_stats* stats, fpint sample) {
+	// remove overwritten sample from sums
+	if(circularbuffer_full(&stats->buffer)) {
+		fpint evicted = *(fpint*) circularbuffer_peek(&stats->buffer);
+		stats->sum         -= evicted;
+		stats->sum_squares -= fpint_mul_wide(evicted, evicted);
+	}
+
+	// add new sample to sums
+	stats->sum         += sample;
+	stats->sum_squares += fpint_mul_wide(sample, sample);
+
+	circularbuffer_save(&stats->buffer, &sample);
+}
+
+int circularbuffer_stats_drain(circularbuffer_stats* stats, fpint* sample) {
+	fpint drained;
+	if(!circularbuffer_drain(&stats->buffer, &drained))
+		return 0;
+
+	// remove drained sample from sums
+	stats->sum         -= drained;
+	stats->sum_squares -= fpint_mul_wide(drained, drained);
+
+	if(sample != NULL)
+		*sample = drained;
+
+	return 1;
+}
+
+/**
+ * divides a sum by number of samples
+ *
+ * (sums fitting into 32 bit are divided without 64 bit division)
+ */
+static long long divide_sum(long long sum, int count) {
+	if(sum >= -0x7FFFFFFFLL && sum <= 0x7FFFFFFFLL)
+		return (long) sum / count;
+
+	return gccbugs_lldiv(sum, count);
+}
+
+fpint circularbuffer_stats_avg(const circularbuffer_stats* stats) {
+	if(circularbuffer_count(&stats->buffer) == 0)
+		return 0;
+
+	return (fpint) divide_sum(stats->sum, circularbuffer_count(&stats->buffer));
+}
+
+fpint circularbuffer_stats_stdev(const circularbuffer_stats* stats) {
+	if(circularbuffer_count(&stats->buffer) == 0)
+		return 0;
+
+	// variance = avg(x^2) - avg(x)^2
+	fpint avg = circularbuffer_stats_avg(stats);
+	long long variance = divide_sum(stats->sum_squares, circularbuffer_count(&stats->buffer)) - fpint_mul_wide(avg, avg);
+
+	// truncation of average may result in tiny negative variance,
+	// variances exceeding the fpint range are limited to it
+	if(variance <= 0)
+		return 0;
+	if(variance > FPINT_MAX)
+		variance = FPINT_MAX;
+
+	return fpint_sqrt((fpint) variance);
+}
+
+fpint circularbuffer_stats_quantile(const circularbuffer_stats* stats, fpint q) {
+	return fpint_add(fpint_mul(q, circularbuffer_stats_stdev(stats)), circularbuffer_stats_avg(stats));
 }
@@ -3,6 +3,138 @@
 
 #include "fpint.h"
 
-void circularbuffer_save(fpint* samples, int size, fpint sample, int* nextpos, int* saved);
+/**
+ * circular buffer of elements of any type
+ *
+ * saving an element into a full buffer replaces the oldest element,
+ * elements are accessed from oldest (position 0) to newest.
+ */
+struct circularbuffer {
+	void* elements;
+	unsigned short element_size;
+	unsigned short size;
+	unsigned short nextpos;
+	unsigned short saved;
+};
+
+/**
+ * initializer of a circular buffer using an array as storage
+ *
+ * static fpint samples[10];
+ * static struct circularbuffer buffer = CIRCULARBUFFER_INIT(samples);
+ */
+#define CIRCULARBUFFER_INIT(elements) { elements, sizeof((elements)[0]), sizeof(elements) / sizeof((elements)[0]), 0, 0 }
+
+/**
+ * declares a static circular buffer "name" for "size" elements of "type"
+ *
+ * CIRCULARBUFFER(samples, fpint, 10);
+ * circularbuffer_save(&samples, &fp_value);
+ */
+#define CIRCULARBUFFER(name, type, size) \
+	static type name##_elements[size]; \
+	static struct circularbuffer name = CIRCULARBUFFER_INIT(name##_elements)
+
+/**
+ * number of saved elements
+ */
+#define circularbuffer_count(buffer) ((buffer)->saved)
+
+/**
+ * whether next save will replace the oldest element
+ */
+#define circularbuffer_full(buffer) ((buffer)->saved == (buffer)->size)
+
+/**
+ * removes all elements
+ */
+void circularbuffer_clear(struct circularbuffer* buffer);
+
+/**
+ * saves a copy of an element (replacing the oldest element when buffer is full)
+ *
+ * returns pointer to saved element
+ */
+void* circularbuffer_save(struct circularbuffer* buffer, const void* element);
+
+/**
+ * gets element at position (0 is oldest element)
+ *
+ * returns pointer to element or NULL
+ */
+void* circularbuffer_get(const struct circularbuffer* buffer, unsigned short pos);
+
+/**
+ * gets oldest element without removing it
+ *
+ * returns pointer to element or NULL
+ */
+void* circularbuffer_peek(const struct circularbuffer* buffer);
+
+/**
+ * removes oldest element and copies it to element (when not NULL)
+ *
+ * (sums of a circularbuffer_stats are kept by circularbuffer_stats_drain)
+ *
+ * returns 1 when an element has been removed, 0 for an empty buffer
+ */
+int circularbuffer_drain(struct circularbuffer* buffer, void* element);
+
+/**
+ * circular buffer of fpint samples with running sum and sum of squares
+ *
+ * sums are updated on every insert and eviction, so average and standard
+ * deviation are calculated without scanning the samples. Both sums are
+ * saved as Q47.16 and can not overflow for any fpint samples.
+ */
+typedef struct {
+	struct circularbuffer buffer;
+	long long sum;
+	long long sum_squares;
+} circularbuffer_stats;
+
+/**
+ * initializer of a circularbuffer_stats using an fpint array as storage
+ */
+#define CIRCULARBUFFER_STATS_INIT(samples) { CIRCULARBUFFER_INIT(samples), 0LL, 0LL }
+
+/**
+ * declares a static circularbuffer_stats "name" for "size" samples
+ */
+#define CIRCULARBUFFER_STATS(name, size) \
+	static fpint name##_elements[size]; \
+	static circularbuffer_stats name = CIRCULARBUFFER_STATS_INIT(name##_elements)
+
+/**
+ * removes all samples
+ */
+void circularbuffer_stats_clear(circularbuffer_stats* stats);
+
+/**
+ * saves a sample (replacing the oldest sample when buffer is full)
+ */
+void circularbuffer_stats_save(circularbuffer_stats* stats, fpint sample);
+
+/**
+ * removes oldest sample and copies it to sample (when not NULL)
+ *
+ * returns 1 when a sample has been removed, 0 for an empty buffer
+ */
+int circularbuffer_stats_drain(circularbuffer_stats* stats, fpint* sample);
+
+/**
+ * average of all saved samples
+ */
+fpint circularbuffer_stats_avg(const circularbuffer_stats* stats);
+
+/**
+ * standard deviation of all saved samples
+ */
+fpint circularbuffer_stats_stdev(const circularbuffer_stats* stats);
+
+/**
+ * quantile of all saved samples (average + q * standard deviation)
+ */
+fpint circularbuffer_stats_quantile(const circularbuffer_stats* stats, fpint q);
 
 #endif /* CIRCULARBUFFER_H_ */
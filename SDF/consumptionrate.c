@@ -2,8 +2,7 @@
 
 #include "sdf-config.h"
 #include "consumptionrate.h"
-#include "circularbuffer.h"
-#include "energymeter.h"
+#include "energyledger.h"
 #include "solarpanel.h"
 #include "battery.h"
 #include "fpint.h"
@@ -12,10 +11,14 @@
 #define DEBUG DEBUG_OFF
 #include "debug.h"
 
+#if CONSUMPTIONRATE_PROFILE && CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION
+	#error CONSUMPTIONRATE_PROFILE needs polling of solarpanel (CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION 0)
+#endif
+
 /**
- * last energymeter sample
+ * position in energy ledger of last sample
  */
-static energymeter_sample last_energymeter_sample;
+static energyledger_cursor cursor;
 
 /**
  * last battery capacity
@@ -23,47 +26,96 @@ static energymeter_sample last_energymeter_sample;
 static fpint fp_last_battery_capacity;
 
 /**
- * next position in consumptionrate buffer
+ * solar harvested energy since last sample
  */
-static int nextpos = 0;
+static fpint fp_solar_energy = 0;
+
+#if CONSUMPTIONRATE_PROFILE
 
 /**
- * number of consumptionrate samples saved
+ * reciprocal of seconds per hour
  */
-int consumptionrate_saved = 0;
+static const fpint_reciprocal reciprocal_hour = FPINT_RECIPROCAL(3600);
 
 /**
- * saved consumptionrate samples
+ * reciprocal of battery reserve
  */
-fpint consumptionrate_samples[CONSUMPTIONRATE_SAMPLES];
+static const fpint_reciprocal reciprocal_reserve = FPINT_RECIPROCAL(CONSUMPTIONRATE_PROFILE_RESERVE);
 
 /**
- * process for periodically polling solar harvested energy
+ * solar harvested energy of every hour of day since last sample
  */
-PROCESS(consumptionrate_solarpanel_process, "Consumptionrate-Solarpanel-Process");
+static fpint fp_harvest_hour[24];
 
 /**
- * solar harvested energy since last sample
+ * share of every hour of day of the daily harvest (unsigned 0.16 fixed point)
  */
-static fpint fp_solar_energy = 0;
+static unsigned short harvest_profile[24];
+
+/**
+ * share of the daily harvest needed for spending the equal share in hours with
+ * less harvest than the equal share ("night", unsigned 0.16 fixed point)
+ */
+static unsigned short night_share = 0;
+
+/**
+ * blends the hourly harvest since last sample into the harvest profile
+ */
+static void profile_update(fpint fp_harvest_day) {
+	int hour;
+	unsigned long night = 0;
+	for(hour = 0; hour < 24; hour++) {
+		if(fp_harvest_day > 0) {
+			fpint fp_share = fpint_min(fpint_div(fp_harvest_hour[hour], fp_harvest_day), 0xFFFF);
+			harvest_profile[hour] = (unsigned short) (((unsigned long) harvest_profile[hour] + fp_share) / 2);
+		}
+		fp_harvest_hour[hour] = 0;
+
+		if(harvest_profile[hour] < 0x10000 / 24)
+			night += 0x10000 / 24 - harvest_profile[hour];
+	}
+	night_share = (unsigned short) night;
+}
+
+#endif
+
+#if CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION == 0
+
+/**
+ * adds energy harvested by solar panel
+ */
+static void solarpanel_harvested(fpint fp_capacity) {
+	fp_solar_energy = fpint_add(fp_solar_energy, fp_capacity);
+	#if CONSUMPTIONRATE_PROFILE
+		fp_harvest_hour[time_hour()] = fpint_add(fp_harvest_hour[time_hour()], fp_capacity);
+	#endif
+}
+
+/**
+ * subscription to solar panel harvest
+ */
+static solarpanel_subscriber solarpanel = { NULL, &solarpanel_harvested };
+
+#endif
 
 void consumptionrate_init() {
-    energymeter_sampling(&last_energymeter_sample);
+    energyledger_cursor_advance(&cursor);
     fp_last_battery_capacity = battery_capacity();
 	#if CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION == 0
-		process_start(&consumptionrate_solarpanel_process, NULL);
+		solarpanel_subscribe(&solarpanel);
+	#endif
+	#if CONSUMPTIONRATE_PROFILE
+		// harvest is distributed equally until first sample
+		int hour;
+		for(hour = 0; hour < 24; hour++)
+			harvest_profile[hour] = 0x10000 / 24;
 	#endif
-
 }
 
 void consumptionrate_sample() {
-	// take energymeter sample
-	static energymeter_sample now;
-	energymeter_sampling(&now);
-
-	// calculate energy consumption rate and save in buffer
+	// calculate energy consumption rate and add to forecaster
 	#if CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION
-		fpint fp_drain = energymeter_calculate_drain(&last_energymeter_sample, &now, ENERGYMETER_DRAIN_WITH_INCOMPLETE_TIMEFRAMES);
+		fpint fp_drain = energyledger_drain(&cursor, ENERGYLEDGER_ALL);
 		fpint fp_battery = fpint_sub(battery_capacity(), fp_last_battery_capacity);
 		fpint fp_consumptionrate = fpint_max(fpint_to(0), fpint_add(fp_battery, fp_drain));
 		debug("[CONSUMPTIONRATE] drain=%smAh, batterydiff=%smAh, consumptionrate=%smAh\n", debug_fpint(fp_drain), debug_fpint(fp_battery), debug_fpint(fp_consumptionrate));
@@ -72,21 +124,13 @@ void consumptionrate_sample() {
 		fp_solar_energy = 0;
 		debug("[CONSUMPTIONRATE] consumptionrate=%smAh\n", debug_fpint(fp_consumptionrate));
 	#endif
-	circularbuffer_save(consumptionrate_samples, CONSUMPTIONRATE_SAMPLES, fp_consumptionrate, &nextpos, &consumptionrate_saved);
-
-	#if DEBUG & DEBUG_ON
-		debug("[CONSUMPTIONRATE] Samples=[");
-		int i = 0;
-		while(i < consumptionrate_saved) {
-			debug("%s", debug_fpint(consumptionrate_samples[i]));
-			if(++i < consumptionrate_saved)
-				debug(", ");
-		}
-		debug("]\n");
+	#if CONSUMPTIONRATE_PROFILE
+		profile_update(fp_consumptionrate);
 	#endif
+	consumptionrate_forecast->update(fp_consumptionrate, time_day());
 
 	// save actual samples
-	memcpy(&last_energymeter_sample, &now, sizeof(energymeter_sample));
+	energyledger_cursor_advance(&cursor);
 	fp_last_battery_capacity = battery_capacity();
 }
 
@@ -110,50 +154,57 @@ static fpint samples_confidence(int s, int s_max, fpint fp_c_start, fpint fp_cl_
 
 static fpint consumptionrate_calc(fpint fp_c_start, fpint fp_cl_max) {
 	// calculate samples confidence
-	fpint fp_confidence = samples_confidence(consumptionrate_saved, CONSUMPTIONRATE_SAMPLES, fp_c_start, fp_cl_max);
+	fpint fp_confidence = samples_confidence(consumptionrate_forecast->samples(), CONSUMPTIONRATE_SAMPLES, fp_c_start, fp_cl_max);
 	debug("[CONSUMPTIONRATE] sample-confidence=%s\n", debug_fpint(fp_confidence));
 
-	// calculate quantile energy
-	fpint fp_q = 0xFFFEB7EC;
-	fpint fp_quantile = fpint_quantile(consumptionrate_samples, consumptionrate_saved, fp_q);
-	debug("[CONSUMPTIONRATE] quantile-energy=%smAh\n", debug_fpint(fp_quantile));
+	// forecast harvested energy
+	fpint fp_forecast = consumptionrate_forecast->forecast(time_day());
+	debug("[CONSUMPTIONRATE] %s-forecast=%smAh\n", consumptionrate_forecast->name, debug_fpint(fp_forecast));
 
-	fpint fp_consumptionrate = fpint_mul(fp_confidence, fp_quantile);
+	fpint fp_consumptionrate = fpint_mul(fp_confidence, fp_forecast);
 	debug("[CONSUMPTIONRATE] consumptionrate=%smAh\n", debug_fpint(fp_consumptionrate));
 
 	return fp_consumptionrate;
 }
 
 fpint consumptionrate_energy(long timeframe) {
+	// reciprocal of intervals per day (timeframe is constant for every caller, so it is only
+	// divided if it changes)
+	static long last_timeframe = SDF_SAMPLINGRATE_UPDATEINTERVAL;
+	static fpint_reciprocal reciprocal_intervals = FPINT_RECIPROCAL(86400L / SDF_SAMPLINGRATE_UPDATEINTERVAL);
+	if(timeframe != last_timeframe) {
+		fpint_reciprocal_set(&reciprocal_intervals, 86400L / timeframe);
+		last_timeframe = timeframe;
+	}
+
 	fpint fp_energy_interval = consumptionrate_calc(0x8000, 0x8000);
-	fpint fp_interval_factor = fpint_div(FPINT_ONE, fpint_to(86400L / timeframe));
-	fpint fp_energy = fpint_mul(fp_interval_factor, fp_energy_interval);
+	fpint fp_energy = fpint_div_reciprocal(fp_energy_interval, &reciprocal_intervals);
+
+	#if CONSUMPTIONRATE_PROFILE
+		// energy of timeframe by harvest profile of actual hour
+		fpint fp_hours = fpint_div_reciprocal(fpint_to(timeframe), &reciprocal_hour);
+		fpint fp_energy_profile = fpint_mul(fpint_mul(fp_energy_interval, (fpint) harvest_profile[time_hour()]), fp_hours);
+		debug("[CONSUMPTIONRATE] profile-energy=%smAh\n", debug_fpint(fp_energy_profile));
+
+		if(fp_energy_profile >= fp_energy) {
+			// hours with more harvest than the equal share follow the harvest profile, only the
+			// part of the surplus needed for the night and not stored above the reserve is saved
+			fpint fp_night    = fpint_mul(fp_energy_interval, (fpint) night_share);
+			fpint fp_reserve  = fpint_mul(battery_maxcapacity(), (fpint) (CONSUMPTIONRATE_PROFILE_RESERVE * FPINT_ONE / 100));
+			fpint fp_headroom = fpint_sub(battery_capacity(), fp_reserve);
+			if(fp_night > 0 && fp_night > fp_headroom) {
+				fpint fp_flatten = fpint_min(FPINT_ONE, fpint_div(fpint_sub(fp_night, fpint_max(FPINT_ZERO, fp_headroom)), fp_night));
+				fp_energy_profile = fpint_sub(fp_energy_profile, fpint_mul(fp_flatten, fpint_sub(fp_energy_profile, fp_energy)));
+			}
+			fp_energy = fp_energy_profile;
+		} else {
+			// hours with less harvest get the equal share bridged by the battery, below reserve
+			// the budget is blended towards the harvest profile with decreasing battery level
+			fpint fp_weight_equal = fpint_div_reciprocal(fpint_to(fpint_min(battery_level(), CONSUMPTIONRATE_PROFILE_RESERVE)), &reciprocal_reserve);
+			fp_energy = fpint_add(fp_energy_profile, fpint_mul(fp_weight_equal, fpint_sub(fp_energy, fp_energy_profile)));
+		}
+	#endif
 	debug("[CONSUMPTIONRATE] timeframe-energy=%smAh\n", debug_fpint(fp_energy));
 
 	return fp_energy;
 }
-
-/**
- * updates periodically energy harvested by solar panel
- */
-PROCESS_THREAD(consumptionrate_solarpanel_process, ev, data) {
-	PROCESS_BEGIN();
-
-	// timer for updating  solar calculation periodically
-	static struct etimer timer_update_solar;
-	etimer_set(&timer_update_solar, CLOCK_SECOND * 60 / SPEEDMULTIPLIER);
-
-	// update loop
-	while(1) {
-		PROCESS_WAIT_UNTIL(etimer_expired(&timer_update_solar));
-
-		// calculate energy flow & save
-		fpint fp_capacity = solarpanel_capacity(60);
-		fp_solar_energy = fpint_add(fp_solar_energy, fp_capacity);
-
-		// restart timer
-		etimer_reset(&timer_update_solar);
-	}
-
-	PROCESS_END();
-}
@@ -4,6 +4,54 @@
 #include "sdf-config.h"
 #include "fpint.h"
 
+/**
+ * forecasters of daily harvested energy (CONSUMPTIONRATE_FORECASTER)
+ */
+#define CONSUMPTIONRATE_FORECASTER_QUANTILE 0
+#define CONSUMPTIONRATE_FORECASTER_EWMA     1
+#define CONSUMPTIONRATE_FORECASTER_SEASONAL 2
+
+/**
+ * forecaster of daily harvested energy
+ *
+ * forecasts are conservative: energy which will be harvested with a probability of about 90%
+ */
+typedef struct {
+	const char* name;
+
+	/**
+	 * removes all samples
+	 */
+	void (*reset)();
+
+	/**
+	 * adds harvested energy of a day
+	 */
+	void (*update)(fpint fp_harvest, unsigned int day);
+
+	/**
+	 * forecast of harvested energy for a day
+	 */
+	fpint (*forecast)(unsigned int day);
+
+	/**
+	 * number of samples used for forecast (at most CONSUMPTIONRATE_SAMPLES)
+	 */
+	int (*samples)();
+} consumptionrate_forecaster;
+
+/**
+ * available forecasters (only the selected forecaster is compiled for motes)
+ */
+extern const consumptionrate_forecaster consumptionrate_forecaster_quantile;
+extern const consumptionrate_forecaster consumptionrate_forecaster_ewma;
+extern const consumptionrate_forecaster consumptionrate_forecaster_seasonal;
+
+/**
+ * forecaster selected by CONSUMPTIONRATE_FORECASTER
+ */
+extern const consumptionrate_forecaster* const consumptionrate_forecast;
+
 /**
  * init consumptionrate functionality
  */
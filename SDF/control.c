@@ -0,0 +1,47 @@
+#include "sdf-config.h"
+#include "control.h"
+#include "byteorder.h"
+
+/**
+ * first byte of every control message
+ */
+#define CONTROL_HEADER (0x80 | CONTROL_VERSION)
+
+int control_encode(const control_message* message, uint8_t* buffer) {
+	uint8_t* pos = buffer;
+	*pos++ = CONTROL_HEADER;
+	*pos++ = message->type;
+	pos = byteorder_put16(pos, message->epoch);
+	pos = byteorder_put16(pos, message->samplingrate);
+	pos = byteorder_put16(pos, message->motes);
+	pos = byteorder_put32(pos, message->fp_energy);
+
+	return pos - buffer;
+}
+
+int control_decode(control_message* message, const uint8_t* buffer, uint16_t length) {
+	if(length != CONTROL_SIZE || buffer[0] != CONTROL_HEADER)
+		return 0;
+
+	message->type         = buffer[1];
+	message->epoch        = byteorder_get16(buffer + 2);
+	message->samplingrate = byteorder_get16(buffer + 4);
+	message->motes        = byteorder_get16(buffer + 6);
+	message->fp_energy    = byteorder_get32(buffer + 8);
+
+	switch(message->type) {
+		case CONTROL_SAMPLINGRATE:
+			return message->samplingrate > 0 && message->samplingrate <= CONTROL_SAMPLINGRATE_MAX && message->fp_energy >= 0;
+		case CONTROL_DEMAND:
+			return message->samplingrate > 0 && message->samplingrate <= CONTROL_SAMPLINGRATE_MAX && message->motes > 0;
+		case CONTROL_REQUEST:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+int control_epoch_newer(uint16_t epoch, uint16_t last) {
+	int16_t diff = (int16_t) (epoch - last);
+	return diff > 0 || diff < -CONTROL_EPOCH_WINDOW;
+}
@@ -0,0 +1,80 @@
+#ifndef CONTROL_H_
+#define CONTROL_H_
+
+#include <stdint.h>
+
+#include "fpint.h"
+
+/**
+ * version of binary control messages
+ *
+ * (first byte of every message is 0x80 | CONTROL_VERSION, sample messages
+ * start with SAMPLE_VERSION < 0x80)
+ */
+#define CONTROL_VERSION 4
+
+/**
+ * size of an encoded control message in bytes
+ *
+ * version (1), type (1), epoch (2), samplingrate (2), motes (2), energy (4)
+ */
+#define CONTROL_SIZE 12
+
+/**
+ * types of control messages
+ *
+ * CONTROL_SAMPLINGRATE: samplingrate limit of a parent for its childs
+ * CONTROL_REQUEST:      request of a child for the samplingrate of its parent
+ * CONTROL_DEMAND:       samplingrate achievable by a child reported to its parent
+ */
+#define CONTROL_SAMPLINGRATE 1
+#define CONTROL_REQUEST      2
+#define CONTROL_DEMAND       3
+
+/**
+ * maximum samplingrate (at least one second between samples of an interval)
+ */
+#define CONTROL_SAMPLINGRATE_MAX (SDF_SAMPLINGRATE_UPDATEINTERVAL - 60)
+
+/**
+ * number of epochs an older epoch is treated as stale (an even older epoch is
+ * treated as the restarted counter of a rebooted sender)
+ */
+#define CONTROL_EPOCH_WINDOW 16
+
+/**
+ * control message between parent and childs
+ *
+ * epoch is increased by the parent with every new samplingrate,
+ * motes is the number of motes whose samples are sent by the sender
+ * (the sender and its subtree, needed for CONTROL_DEMAND),
+ * fp_energy is the energy budget of the sender for the next interval in mAh
+ */
+typedef struct {
+	uint8_t type;
+	uint16_t epoch;
+	uint16_t samplingrate;
+	uint16_t motes;
+	fpint fp_energy;
+} control_message;
+
+/**
+ * encodes a control message into buffer (at least CONTROL_SIZE bytes)
+ *
+ * returns number of bytes written
+ */
+int control_encode(const control_message* message, uint8_t* buffer);
+
+/**
+ * decodes and validates a control message
+ *
+ * returns 1 for a valid message, 0 for an invalid one
+ */
+int control_decode(control_message* message, const uint8_t* buffer, uint16_t length);
+
+/**
+ * whether epoch is newer than last received epoch
+ */
+int control_epoch_newer(uint16_t epoch, uint16_t last);
+
+#endif /* CONTROL_H_ */
@@ -0,0 +1,133 @@
+#include <string.h>
+
+#include "contiki.h"
+#include "sdf-config.h"
+
+#include "energyledger.h"
+#include "energymeter.h"
+#include "fpint.h"
+
+/**
+ * cumulative drain of every source since start
+ *
+ * values are fpint mAh wrapping at 2^32, so differences of up to 32767mAh
+ * are calculated correctly with 32 bit subtraction
+ */
+static uint32_t drain[ENERGYLEDGER_SOURCES];
+
+/**
+ * energymeter ticks already added to the ledger
+ */
+static energymeter_sample accounted;
+
+/**
+ * clock time of last ledger update
+ */
+static clock_time_t last_update;
+
+/**
+ * whether ledger has been updated at all
+ */
+static int updated = 0;
+
+/**
+ * seconds of a single watchdog timer period
+ *
+ * (etimer intervals are limited by the 16 bit clock: 512 seconds on tmote sky)
+ */
+#define WATCHDOG_PERIOD 480
+
+/**
+ * watchdog process updating the ledger before energest overflows
+ */
+PROCESS(energyledger_process, "Energyledger-Process");
+
+/**
+ * adds drain of all full timeframes of a source to the ledger
+ *
+ * (ticks of incomplete timeframes are kept for next update, so no drain gets lost)
+ */
+static void account(int source, uint32_t (*drainfunc)(uint32_t, fpint, fpint*, int), uint32_t now, uint32_t* last, fpint fp_energy) {
+	fpint fp_drain;
+	*last += (*drainfunc)(now - *last, fp_energy, &fp_drain, ENERGYMETER_DRAIN_ONLY_FULL_TIMEFRAMES);
+	drain[source] += (uint32_t) fp_drain;
+}
+
+void energyledger_init() {
+	process_start(&energyledger_process, NULL);
+}
+
+void energyledger_update() {
+	static energymeter_sample now;
+	energymeter_sampling(&now);
+	last_update = clock_time();
+	updated     = 1;
+
+	// (cpu sleep drain is too small to be calculated for seconds)
+	account(ENERGYLEDGER_CPU_ACTIVE,     &energymeter_drain_seconds, now.cpu_active,     &accounted.cpu_active,     ENERGYMETER_DRAIN_SECONDS_CPU_ACTIVE);
+	account(ENERGYLEDGER_CPU_SLEEP,      &energymeter_drain_hours,   now.cpu_sleep,      &accounted.cpu_sleep,      ENERGYMETER_DRAIN_HOURS_CPU_SLEEP);
+	account(ENERGYLEDGER_RADIO_TRANSMIT, &energymeter_drain_seconds, now.radio_transmit, &accounted.radio_transmit, ENERGYMETER_DRAIN_SECONDS_RADIO_TRANSMIT);
+	account(ENERGYLEDGER_RADIO_LISTEN,   &energymeter_drain_seconds, now.radio_listen,   &accounted.radio_listen,   ENERGYMETER_DRAIN_SECONDS_RADIO_LISTEN);
+	account(ENERGYLEDGER_SENSOR_CO,      &energymeter_drain_seconds, now.sensor_co,      &accounted.sensor_co,      ENERGYMETER_DRAIN_SECONDS_SENSOR_CO);
+	account(ENERGYLEDGER_SENSOR_CO2,     &energymeter_drain_seconds, now.sensor_co2,     &accounted.sensor_co2,     ENERGYMETER_DRAIN_SECONDS_SENSOR_CO2);
+	account(ENERGYLEDGER_SENSOR_GPS,     &energymeter_drain_seconds, now.sensor_gps,     &accounted.sensor_gps,     ENERGYMETER_DRAIN_SECONDS_SENSOR_GPS);
+}
+
+/**
+ * updates ledger on read, but only once per clock tick
+ *
+ * (a skipped update does not loose drain, it's only added by the next update)
+ */
+static void update_lazy() {
+	if(!updated || clock_time() != last_update)
+		energyledger_update();
+}
+
+fpint energyledger_drain(const energyledger_cursor* cursor, int source) {
+	update_lazy();
+
+	if(source != ENERGYLEDGER_ALL)
+		return (fpint) (drain[source] - cursor->drain[source]);
+
+	uint32_t sum = 0;
+	int i;
+	for(i = 0; i < ENERGYLEDGER_SOURCES; i++)
+		sum += drain[i] - cursor->drain[i];
+
+	return (fpint) sum;
+}
+
+void energyledger_cursor_advance(energyledger_cursor* cursor) {
+	update_lazy();
+	memcpy(cursor->drain, drain, sizeof(drain));
+}
+
+/**
+ * updates the ledger every ENERGYLEDGER_WATCHDOGINTERVAL seconds
+ *
+ * (drains are updated on read, the watchdog only ensures the energymeter is sampled
+ * often enough to not miss energest overflows when nobody reads the ledger)
+ */
+PROCESS_THREAD(energyledger_process, ev, data) {
+	PROCESS_BEGIN();
+
+	// watchdog interval is counted in timer periods
+	static struct etimer timer_watchdog;
+	static unsigned int periods = 0;
+	etimer_set(&timer_watchdog, CLOCK_SECOND * WATCHDOG_PERIOD);
+
+	// update loop
+	while(1) {
+		PROCESS_WAIT_UNTIL(etimer_expired(&timer_watchdog));
+
+		if(++periods >= ENERGYLEDGER_WATCHDOGINTERVAL / WATCHDOG_PERIOD) {
+			energyledger_update();
+			periods = 0;
+		}
+
+		// restart timer
+		etimer_reset(&timer_watchdog);
+	}
+
+	PROCESS_END();
+}
@@ -0,0 +1,57 @@
+#ifndef ENERGYLEDGER_H_
+#define ENERGYLEDGER_H_
+
+#include "sdf-config.h"
+#include "fpint.h"
+
+/**
+ * energy drain sources of the ledger
+ */
+#define ENERGYLEDGER_CPU_ACTIVE     0
+#define ENERGYLEDGER_CPU_SLEEP      1
+#define ENERGYLEDGER_RADIO_TRANSMIT 2
+#define ENERGYLEDGER_RADIO_LISTEN   3
+#define ENERGYLEDGER_SENSOR_CO      4
+#define ENERGYLEDGER_SENSOR_CO2     5
+#define ENERGYLEDGER_SENSOR_GPS     6
+#define ENERGYLEDGER_SOURCES        7
+
+/**
+ * pseudo source: summed drain of all sources
+ */
+#define ENERGYLEDGER_ALL ENERGYLEDGER_SOURCES
+
+/**
+ * position of a consumer in the ledger
+ *
+ * a zero initialized cursor is positioned at the start of the ledger
+ */
+typedef struct {
+	uint32_t drain[ENERGYLEDGER_SOURCES];
+} energyledger_cursor;
+
+/**
+ * starts the energy ledger watchdog process
+ */
+void energyledger_init();
+
+/**
+ * takes an energymeter sample and adds the drain of all sources to the ledger
+ *
+ * (done automatically on reading the ledger and by the watchdog process)
+ */
+void energyledger_update();
+
+/**
+ * drain of a source in mAh since cursor
+ *
+ * (drains up to 32767mAh between cursor and ledger can be calculated)
+ */
+fpint energyledger_drain(const energyledger_cursor* cursor, int source);
+
+/**
+ * moves cursor to actual drain
+ */
+void energyledger_cursor_advance(energyledger_cursor* cursor);
+
+#endif /* ENERGYLEDGER_H_ */
@@ -7,13 +7,28 @@
 #include "gps-sensor.h"
 #include "co-sensor.h"
 #include "drandom.h"
-#include "gccbugs.h"
 #include "fpint.h"
 
 /**
  * lifetime energymeter tickcounter
+ *
+ * single 64 bit base of all energymeter samples, samples only contain the lower 32 bit
  */
-static energymeter_sample lifetime = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
+static struct {
+    unsigned long long cpu_active;
+    unsigned long long cpu_sleep;
+    unsigned long long radio_transmit;
+    unsigned long long radio_listen;
+    unsigned long long sensor_co;
+    unsigned long long sensor_co2;
+    unsigned long long sensor_gps;
+} lifetime = {0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL, 0ULL};
+
+/**
+ * reciprocals of ticks per drain timeframe
+ */
+static const fpint_reciprocal reciprocal_seconds = FPINT_RECIPROCAL(ENERGYMETER_TICKS_PER_SECOND);
+static const fpint_reciprocal reciprocal_hours   = FPINT_RECIPROCAL(ENERGYMETER_TICKS_PER_SECOND * 3600UL);
 
 /**
  * last tickcounter of energest modules
@@ -38,11 +53,10 @@ static void updateEnergest(unsigned long energest, unsigned long long* lifetime,
  * on tmote sky the (2^32)-1 energest value has a resolution of 1.5 days (32768 ticks/second),
  * so every 1.5 days the value will overflow and it's not possible to calculate energy drains
  * for a longer period of 1.5 days. Therefore the energest values are saved to an unsigned 64bit
- * integer for infinte long energy measurement periods.
+ * integer for infinte long energy measurement periods, samples contain only the lower 32 bit
+ * (drain calculations are limited to samples less than 1.5 days apart).
  * The energymeter_sampling() function has to be called at least once every 1.5 days to save the
- * values. In the actual implementation the battery is the component ensuring this periodic call,
- * when this should not be not given in the future a separate energymeter process is required to
- * meet the requirements
+ * values. In the actual implementation the energy ledger process is ensuring this periodic call.
  */
 void energymeter_sampling(energymeter_sample* fill) {
     // save actual energy data to internal energest structure:
@@ -56,8 +70,14 @@ void energymeter_sampling(energymeter_sample* fill) {
     updateEnergest(energest_type_time(ENERGEST_TYPE_TRANSMIT), &lifetime.radio_transmit, &last_energest_radio_transmit);
     updateEnergest(energest_type_time(ENERGEST_TYPE_LISTEN),   &lifetime.radio_listen,   &last_energest_radio_listen);
 
-    // copy values of lifetime sample to sampled sample
-    memcpy(fill, &lifetime, sizeof(energymeter_sample));
+    // copy lower 32 bit of lifetime values to sampled sample
+    fill->cpu_active     = (uint32_t) lifetime.cpu_active;
+    fill->cpu_sleep      = (uint32_t) lifetime.cpu_sleep;
+    fill->radio_transmit = (uint32_t) lifetime.radio_transmit;
+    fill->radio_listen   = (uint32_t) lifetime.radio_listen;
+    fill->sensor_co      = (uint32_t) lifetime.sensor_co;
+    fill->sensor_co2     = (uint32_t) lifetime.sensor_co2;
+    fill->sensor_gps     = (uint32_t) lifetime.sensor_gps;
 }
 
 fpint energymeter_calculate_drain(const energymeter_sample* last, const energymeter_sample* now, int only_full_timeframes) {
@@ -70,9 +90,9 @@ fpint energymeter_calculate_drain(const energymeter_sample* last, const energyme
 /**
  * calculates drain with given drain function and adds to absolute drain
  */
-static void update_drain_generic(unsigned long long (*drainfunc)(const unsigned long long*, const unsigned long long*, fpint, fpint*, int), const unsigned long long* now, unsigned long long* last, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
+static void update_drain_generic(uint32_t (*drainfunc)(uint32_t, fpint, fpint*, int), const uint32_t* now, uint32_t* last, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
 	fpint fp_drain_mote;
-	*last += (*drainfunc)(last, now, fp_energy, &fp_drain_mote, timeframe_option);
+	*last += (*drainfunc)(*now - *last, fp_energy, &fp_drain_mote, timeframe_option);
 	*fp_drain = fpint_add(*fp_drain, fp_drain_mote);
 }
 
@@ -96,30 +116,25 @@ fpint energymeter_calculate_drain_update_last(energymeter_sample* last, const en
 /**
  * generic calculation of drain
  */
-static unsigned long long drain_generic(const unsigned long long* last, const unsigned long long* now, fpint fp_energy, fpint* fp_drain, unsigned long long timeframe, int timeframe_option) {
-	unsigned long long ticks_calculated = 0;
-
+static uint32_t drain_generic(uint32_t tickdiff, fpint fp_energy, fpint* fp_drain, const fpint_reciprocal* timeframe, int timeframe_option) {
 	// save empty drain in "return" (maybe no drain will be calculated so default to zero)
 	*fp_drain = fpint_to(0);
 
-	// calculate tick difference
-	unsigned long long tickdiff = *now - *last;
-
 	// calculate number of timeframes between last and now
-	unsigned long long timeframes = gccbugs_ulldiv(tickdiff, timeframe);
+	unsigned long timeframes = fpint_udiv_reciprocal(tickdiff, timeframe);
 
 	// save calculated ticks and and reduce tickdiff
-	ticks_calculated = timeframes * timeframe;
+	uint32_t ticks_calculated = timeframes * timeframe->divisor;
 	tickdiff -= ticks_calculated;
 
 	// calculate needed energy for timeframes
 	if(timeframes > 0)
-		*fp_drain = fpint_multimes(fp_energy, (unsigned long) timeframes);
+		*fp_drain = fpint_multimes(fp_energy, timeframes);
 
 	// calculate energy drain for incomplete timeframes
 	if(timeframe_option == ENERGYMETER_DRAIN_WITH_INCOMPLETE_TIMEFRAMES && tickdiff > 0) {
 		long l_tickdiff  = (long) tickdiff;
-		long l_timeframe = (long) timeframe;
+		long l_timeframe = (long) timeframe->divisor;
 
 		// calculate seconds the drain has to be calculated for
 		// timeframe may overflow fpint on platform, workaround:
@@ -136,18 +151,18 @@ static unsigned long long drain_generic(const unsigned long long* last, const un
 	return ticks_calculated;
 }
 
-unsigned long long energymeter_drain_seconds(const unsigned long long* last, const unsigned long long* now, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
-	return drain_generic(last, now, fp_energy, fp_drain, ENERGYMETER_TICKS_PER_SECOND, timeframe_option);
+uint32_t energymeter_drain_seconds(uint32_t ticks, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
+	return drain_generic(ticks, fp_energy, fp_drain, &reciprocal_seconds, timeframe_option);
 }
 
-unsigned long long energymeter_drain_hours(const unsigned long long* last, const unsigned long long* now, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
-	return drain_generic(last, now, fp_energy, fp_drain, ENERGYMETER_TICKS_PER_SECOND * 3600ULL, timeframe_option);
+uint32_t energymeter_drain_hours(uint32_t ticks, fpint fp_energy, fpint* fp_drain, int timeframe_option) {
+	return drain_generic(ticks, fp_energy, fp_drain, &reciprocal_hours, timeframe_option);
 }
 
 int co2_value() {
 	// co2 sensor runs 0.5s-1s
 	int seconddiff = drandom_rand_minmax(1, 2);
-    lifetime.sensor_co2 += gccbugs_ulldiv(ENERGYMETER_TICKS_PER_SECOND, seconddiff);
+    lifetime.sensor_co2 += ENERGYMETER_TICKS_PER_SECOND / seconddiff;
 
     // TGS4161 is specified for 350~10000ppm
     return drandom_rand_minmax(350, 10000);
@@ -168,5 +183,5 @@ void gps_value(gps_position* position) {
 	lifetime.sensor_gps += ENERGYMETER_TICKS_PER_SECOND * seconds;
 
     position->latitude = 0x31E0A0;
-    position->latitude = 0x8A789;
+    position->longitude = 0x8A789;
 }
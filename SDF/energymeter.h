@@ -23,21 +23,33 @@
 /**
  * number of energymeter ticks forming an second
  */
-#define ENERGYMETER_TICKS_PER_SECOND (unsigned long long) RTIMER_SECOND
+#define ENERGYMETER_TICKS_PER_SECOND (unsigned long) RTIMER_SECOND
 
 /**
  * datastructure of an energymeter sample
+ *
+ * a sample holds the lower 32 bit of the 64 bit lifetime tickcounters kept by the
+ * energymeter. Differences between two samples are therefore calculated correctly
+ * (even on overflow) as long as both samples are not more than 2^32 ticks (1.5 days
+ * on tmote sky) apart, which allows all drain calculations to be done in 32 bit.
  */
 typedef struct {
-    unsigned long long cpu_active;
-    unsigned long long cpu_sleep;
-    unsigned long long radio_transmit;
-    unsigned long long radio_listen;
-    unsigned long long sensor_co;
-    unsigned long long sensor_co2;
-    unsigned long long sensor_gps;
+    uint32_t cpu_active;
+    uint32_t cpu_sleep;
+    uint32_t radio_transmit;
+    uint32_t radio_listen;
+    uint32_t sensor_co;
+    uint32_t sensor_co2;
+    uint32_t sensor_gps;
 } energymeter_sample;
 
+/**
+ * ticks of a source between two energymeter samples
+ *
+ * energymeter_delta(&last, &now, radio_transmit)
+ */
+#define energymeter_delta(last, now, source) ((uint32_t) ((now)->source - (last)->source))
+
 /**
  * takes an energymeter sample
  */
@@ -64,17 +76,17 @@ fpint energymeter_calculate_drain(const energymeter_sample* last, const energyme
 fpint energymeter_calculate_drain_update_last(energymeter_sample* last, const energymeter_sample* now, int timeframe_option);
 
 /**
- * calculates drain of a source in second resolution
+ * calculates drain of a source for a tick difference in second resolution
  *
  * returns number of ticks used in calculation
  */
-unsigned long long energymeter_drain_seconds(const unsigned long long* last, const unsigned long long* now, fpint fp_energy, fpint* fp_drain, int timeframe_option);
+uint32_t energymeter_drain_seconds(uint32_t ticks, fpint fp_energy, fpint* fp_drain, int timeframe_option);
 
 /**
- * calculates drain of a source in hour resolution
+ * calculates drain of a source for a tick difference in hour resolution
  *
  * returns number of ticks used in calculation
  */
-unsigned long long energymeter_drain_hours(const unsigned long long* last, const unsigned long long* now, fpint fp_energy, fpint* fp_drain, int timeframe_option);
+uint32_t energymeter_drain_hours(uint32_t ticks, fpint fp_energy, fpint* fp_drain, int timeframe_option);
 
 #endif /* __ENERGYMETER_H__ */
@@ -0,0 +1,216 @@
+#include "sdf-config.h"
+#include "consumptionrate.h"
+#include "circularbuffer.h"
+#include "fpint.h"
+
+/**
+ * all forecasters are compiled for host (sdf-forecast replay harness),
+ * only the selected forecaster for motes
+ */
+#define FORECASTER(id) (CONSUMPTIONRATE_FORECASTER == (id) || CONTIKI_TARGET_HOST)
+
+/**
+ * quantile of normal distribution for forecasts (-1.28: 10% quantile)
+ */
+#define FORECASTER_QUANTILE 0xFFFEB7EC
+
+/**
+ *
+ *
+ * quantile of last CONSUMPTIONRATE_SAMPLES days
+ *
+ *
+ */
+#if FORECASTER(CONSUMPTIONRATE_FORECASTER_QUANTILE)
+
+/**
+ * saved daily harvest samples
+ */
+CIRCULARBUFFER_STATS(quantile_samples, CONSUMPTIONRATE_SAMPLES);
+
+static void quantile_reset() {
+	circularbuffer_stats_clear(&quantile_samples);
+}
+
+static void quantile_update(fpint fp_harvest, unsigned int day) {
+	circularbuffer_stats_save(&quantile_samples, fp_harvest);
+}
+
+static fpint quantile_forecast(unsigned int day) {
+	return circularbuffer_stats_quantile(&quantile_samples, FORECASTER_QUANTILE);
+}
+
+static int quantile_count() {
+	return circularbuffer_count(&quantile_samples.buffer);
+}
+
+const consumptionrate_forecaster consumptionrate_forecaster_quantile = {
+	"quantile", &quantile_reset, &quantile_update, &quantile_forecast, &quantile_count
+};
+
+#endif
+
+/**
+ *
+ *
+ * exponentially weighted moving average and variance
+ *
+ *
+ */
+#if FORECASTER(CONSUMPTIONRATE_FORECASTER_EWMA)
+
+/**
+ * weighted average, weighted variance and number of samples
+ */
+static fpint fp_ewma_avg, fp_ewma_variance;
+static int ewma_samples = 0;
+
+static void ewma_reset() {
+	fp_ewma_avg      = 0;
+	fp_ewma_variance = 0;
+	ewma_samples     = 0;
+}
+
+static void ewma_update(fpint fp_harvest, unsigned int day) {
+	if(ewma_samples++ == 0) {
+		fp_ewma_avg = fp_harvest;
+		return;
+	}
+
+	// avg += w * diff, variance = (1 - w) * (variance + w * diff^2)
+	fpint fp_diff = fpint_sub(fp_harvest, fp_ewma_avg);
+	long long squared = fpint_mul_wide(fp_diff, fp_diff);
+	fpint fp_squared = (squared > FPINT_MAX) ? FPINT_MAX : (fpint) squared;
+
+	fp_ewma_avg      = fpint_add(fp_ewma_avg, fpint_mul(CONSUMPTIONRATE_FORECASTER_EWMA_WEIGHT, fp_diff));
+	fp_ewma_variance = fpint_mul(fpint_sub(FPINT_ONE, CONSUMPTIONRATE_FORECASTER_EWMA_WEIGHT),
+	                             fpint_add(fp_ewma_variance, fpint_mul(CONSUMPTIONRATE_FORECASTER_EWMA_WEIGHT, fp_squared)));
+}
+
+static fpint ewma_forecast(unsigned int day) {
+	return fpint_add(fp_ewma_avg, fpint_mul(FORECASTER_QUANTILE, fpint_sqrt(fp_ewma_variance)));
+}
+
+static int ewma_count() {
+	return (ewma_samples < CONSUMPTIONRATE_SAMPLES) ? ewma_samples : CONSUMPTIONRATE_SAMPLES;
+}
+
+const consumptionrate_forecaster consumptionrate_forecaster_ewma = {
+	"ewma", &ewma_reset, &ewma_update, &ewma_forecast, &ewma_count
+};
+
+#endif
+
+/**
+ *
+ *
+ * day of year trend (linear regression) of last CONSUMPTIONRATE_SAMPLES days
+ *
+ *
+ */
+#if FORECASTER(CONSUMPTIONRATE_FORECASTER_SEASONAL)
+
+/**
+ * harvest of a day
+ */
+typedef struct {
+	unsigned int day;
+	fpint fp_harvest;
+} seasonal_sample;
+
+/**
+ * saved daily harvest samples
+ */
+CIRCULARBUFFER(seasonal_samples, seasonal_sample, CONSUMPTIONRATE_SAMPLES);
+
+/**
+ * days from a reference day to a day (wrapping at end of year)
+ */
+static int day_offset(unsigned int reference, unsigned int day) {
+	int offset = (int) day - (int) reference;
+	if(offset > 182)
+		offset -= 365;
+	if(offset < -182)
+		offset += 365;
+
+	return offset;
+}
+
+static void seasonal_reset() {
+	circularbuffer_clear(&seasonal_samples);
+}
+
+static void seasonal_update(fpint fp_harvest, unsigned int day) {
+	seasonal_sample sample = { day, fp_harvest };
+	circularbuffer_save(&seasonal_samples, &sample);
+}
+
+static fpint seasonal_forecast(unsigned int day) {
+	int i, count = circularbuffer_count(&seasonal_samples);
+	if(count == 0)
+		return 0;
+
+	// days are relative to the newest sample
+	unsigned int reference = ((seasonal_sample*) circularbuffer_get(&seasonal_samples, count - 1))->day;
+	fpint_reciprocal reciprocal_count;
+	fpint_reciprocal_set(&reciprocal_count, count);
+
+	// averages of day and harvest
+	fpint fp_avg_day = 0, fp_avg_harvest = 0;
+	for(i = 0; i < count; i++) {
+		seasonal_sample* sample = circularbuffer_get(&seasonal_samples, i);
+		fp_avg_day     = fpint_add(fp_avg_day, fpint_to(day_offset(reference, sample->day)));
+		fp_avg_harvest = fpint_add(fp_avg_harvest, sample->fp_harvest);
+	}
+	fp_avg_day     = fpint_div_reciprocal(fp_avg_day, &reciprocal_count);
+	fp_avg_harvest = fpint_div_reciprocal(fp_avg_harvest, &reciprocal_count);
+
+	// slope of harvest per day (covariance / variance of days)
+	fpint fp_variance_day = 0, fp_covariance = 0;
+	for(i = 0; i < count; i++) {
+		seasonal_sample* sample = circularbuffer_get(&seasonal_samples, i);
+		fpint fp_dx = fpint_sub(fpint_to(day_offset(reference, sample->day)), fp_avg_day);
+		fpint fp_dy = fpint_sub(sample->fp_harvest, fp_avg_harvest);
+		fp_variance_day = fpint_add(fp_variance_day, fpint_div_reciprocal(fpint_mul(fp_dx, fp_dx), &reciprocal_count));
+		fp_covariance   = fpint_add(fp_covariance,   fpint_div_reciprocal(fpint_mul(fp_dx, fp_dy), &reciprocal_count));
+	}
+	fpint fp_slope = (fp_variance_day > 0) ? fpint_div(fp_covariance, fp_variance_day) : 0;
+
+	// variance of harvest around trend
+	fpint fp_variance = 0;
+	for(i = 0; i < count; i++) {
+		seasonal_sample* sample = circularbuffer_get(&seasonal_samples, i);
+		fpint fp_dx       = fpint_sub(fpint_to(day_offset(reference, sample->day)), fp_avg_day);
+		fpint fp_residual = fpint_sub(sample->fp_harvest, fpint_add(fp_avg_harvest, fpint_mul(fp_slope, fp_dx)));
+		long long squared = fpint_mul_wide(fp_residual, fp_residual);
+		fpint fp_squared  = (squared > FPINT_MAX) ? FPINT_MAX : (fpint) squared;
+		fp_variance = fpint_add(fp_variance, fpint_div_reciprocal(fp_squared, &reciprocal_count));
+	}
+
+	// trend at forecasted day
+	fpint fp_dx    = fpint_sub(fpint_to(day_offset(reference, day)), fp_avg_day);
+	fpint fp_trend = fpint_add(fp_avg_harvest, fpint_mul(fp_slope, fp_dx));
+
+	return fpint_max(0, fpint_add(fp_trend, fpint_mul(FORECASTER_QUANTILE, fpint_sqrt(fp_variance))));
+}
+
+static int seasonal_count() {
+	return circularbuffer_count(&seasonal_samples);
+}
+
+const consumptionrate_forecaster consumptionrate_forecaster_seasonal = {
+	"seasonal", &seasonal_reset, &seasonal_update, &seasonal_forecast, &seasonal_count
+};
+
+#endif
+
+/**
+ * selected forecaster
+ */
+#if CONSUMPTIONRATE_FORECASTER == CONSUMPTIONRATE_FORECASTER_EWMA
+	const consumptionrate_forecaster* const consumptionrate_forecast = &consumptionrate_forecaster_ewma;
+#elif CONSUMPTIONRATE_FORECASTER == CONSUMPTIONRATE_FORECASTER_SEASONAL
+	const consumptionrate_forecaster* const consumptionrate_forecast = &consumptionrate_forecaster_seasonal;
+#else
+	const consumptionrate_forecaster* const consumptionrate_forecast = &consumptionrate_forecaster_quantile;
+#endif
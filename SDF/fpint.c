@@ -1,8 +1,14 @@
 #include <stdio.h>
 
+#include "sdf-config.h"
 #include "fpint.h"
 #include "gccbugs.h"
 
+#ifdef __MSP430__
+	#include <io.h>
+	#include "contiki.h"
+#endif
+
 /**
  * algorithm does work by dividing decimal place scled by a factor of
  * ten in every step to fraction bit and adding value whenever bit is set.
@@ -17,7 +23,7 @@ char* fpint_str(fpint a, char* buf) {
 	}
 
 	// save integer part to string
-	nextpos += sprintf(buf + nextpos, "%ld", fpint_from(a));
+	nextpos += sprintf(buf + nextpos, "%ld", (long) fpint_from(a));
 
 	// add decimal point
 	buf[nextpos++] = '.';
@@ -44,8 +50,74 @@ char* fpint_str(fpint a, char* buf) {
 	return buf;
 }
 
+/**
+ * multiplies two 16 bit values to a 32 bit product
+ */
+static unsigned long umul16(unsigned short a, unsigned short b) {
+	#if defined(__MSP430_HAS_MPY__) || defined(__MSP430_HAS_MPY32__)
+		// hardware multiplier registers may be used by interrupts too
+		int sr = splhigh();
+		MPY = a;
+		OP2 = b;
+		unsigned long product = ((unsigned long) RESHI << 16) | RESLO;
+		splx(sr);
+
+		return product;
+	#else
+		return (unsigned long) a * b;
+	#endif
+}
+
+/**
+ * bits 16 to 47 of the 64 bit product of a and b are calculated with four
+ * 16x16 bit multiplications (which are mapped to hardware multiplier) and
+ * without any 64 bit arithmetic:
+ *
+ * unsigned: (a * b) >> 16 = (ah * bh) << 16 + ah * bl + al * bh + (al * bl) >> 16
+ * signed:   two's complement of a (or b) adds b << 32 (or a << 32) to the unsigned
+ *           product, so it's subtracted from the middle bits again
+ *
+ * The result is bit identical to (gccbugs_llmul(a, b) >> 16).
+ */
 fpint fpint_mul(fpint a, fpint b) {
-    return (fpint) (gccbugs_llmul(a, b) >> 16);
+	unsigned long ua = (unsigned long) a, ub = (unsigned long) b;
+	unsigned short al = (unsigned short) ua, ah = (unsigned short) (ua >> 16);
+	unsigned short bl = (unsigned short) ub, bh = (unsigned short) (ub >> 16);
+
+	unsigned long product = umul16(ah, bh) << 16;
+	product += umul16(ah, bl);
+	product += umul16(al, bh);
+	product += umul16(al, bl) >> 16;
+
+	// sign correction
+	if(a < 0)
+		product -= ub << 16;
+	if(b < 0)
+		product -= ua << 16;
+
+	return (fpint) product;
+}
+
+/**
+ * same partial products as fpint_mul() but all 64 bits are kept
+ */
+long long fpint_mul_wide(fpint a, fpint b) {
+	unsigned long ua = (unsigned long) a, ub = (unsigned long) b;
+	unsigned short al = (unsigned short) ua, ah = (unsigned short) (ua >> 16);
+	unsigned short bl = (unsigned short) ub, bh = (unsigned short) (ub >> 16);
+
+	unsigned long ll = umul16(al, bl), lh = umul16(al, bh), hl = umul16(ah, bl);
+	unsigned long middle = (ll >> 16) + (lh & 0xFFFF) + (hl & 0xFFFF);
+	uint32_t low  = (ll & 0xFFFF) | (middle << 16);
+	uint32_t high = umul16(ah, bh) + (lh >> 16) + (hl >> 16) + (middle >> 16);
+
+	// sign correction
+	if(a < 0)
+		high -= ub;
+	if(b < 0)
+		high -= ua;
+
+	return ((long long) (((unsigned long long) high << 32) | low)) >> 16;
 }
 
 fpint fpint_multimes(fpint a, unsigned long times) {
@@ -66,6 +138,52 @@ fpint fpint_div(fpint a, fpint b) {
     return (fpint) gccbugs_lldiv(scaled, b);
 }
 
+/**
+ * high 32 bits of the 64 bit product of two unsigned longs
+ */
+static unsigned long umulhi32(unsigned long a, unsigned long b) {
+	unsigned short al = (unsigned short) a, ah = (unsigned short) (a >> 16);
+	unsigned short bl = (unsigned short) b, bh = (unsigned short) (b >> 16);
+
+	unsigned long ll = umul16(al, bl), lh = umul16(al, bh), hl = umul16(ah, bl);
+
+	// middle column with carries of lower column
+	unsigned long middle = (ll >> 16) + (lh & 0xFFFF) + (hl & 0xFFFF);
+
+	return umul16(ah, bh) + (lh >> 16) + (hl >> 16) + (middle >> 16);
+}
+
+void fpint_reciprocal_set(fpint_reciprocal* r, unsigned long divisor) {
+	r->divisor    = divisor;
+	r->multiplier = 0xFFFFFFFFUL / divisor;
+}
+
+/**
+ * a / d = (a * (2^32 / d)) >> 32
+ *
+ * the multiplier floor((2^32-1) / d) is rounded down, so the quotient may
+ * be too small by up to two and is corrected by checking the remainder
+ */
+unsigned long fpint_udiv_reciprocal(unsigned long a, const fpint_reciprocal* r) {
+	unsigned long quotient = umulhi32(a, r->multiplier);
+	unsigned long remainder = a - quotient * r->divisor;
+
+	while(remainder >= r->divisor) {
+		quotient++;
+		remainder -= r->divisor;
+	}
+
+	return quotient;
+}
+
+fpint fpint_div_reciprocal(fpint a, const fpint_reciprocal* r) {
+	// truncate towards zero like fpint_div()
+	if(a < 0)
+		return -(fpint) fpint_udiv_reciprocal(-(unsigned long) a, r);
+
+	return (fpint) fpint_udiv_reciprocal((unsigned long) a, r);
+}
+
 fpint fpint_ceil(fpint a) {
 	fpint ceil = fpint_floor(a);
 	if((a & 0xFFFF) > 0)
@@ -96,44 +214,142 @@ fpint fpint_abs(fpint a) {
     return (a >= 0) ? a : fpint_sub(FPINT_ZERO, a);
 }
 
-// sin(x) ≈ 0,0375758*x^4 - 0,236096*x^3 + 0,0582877*x^2 + 0,0981968*x
+/**
+ * quarter sine wave sin([0, PI/2]) in FPINT_SIN_TABLESIZE steps (fraction bits of fpint)
+ * and scale of fpint angle to table position (FPINT_SIN_TABLESIZE / (PI/2))
+ */
+#if FPINT_SIN_TABLESIZE == 16
+	#define SIN_TABLE_SCALE 0xA2F98L
+	static const unsigned short sin_table[FPINT_SIN_TABLESIZE + 1] = {
+		0x0000, 0x1918, 0x31F1, 0x4A50, 0x61F8, 0x78AD, 0x8E3A, 0xA268,
+		0xB505, 0xC5E4, 0xD4DB, 0xE1C6, 0xEC83, 0xF4FA, 0xFB15, 0xFEC4,
+		0xFFFF
+	};
+#elif FPINT_SIN_TABLESIZE == 32
+	#define SIN_TABLE_SCALE 0x145F30L
+	static const unsigned short sin_table[FPINT_SIN_TABLESIZE + 1] = {
+		0x0000, 0x0C90, 0x1918, 0x2590, 0x31F1, 0x3E34, 0x4A50, 0x563E,
+		0x61F8, 0x6D74, 0x78AD, 0x839C, 0x8E3A, 0x9880, 0xA268, 0xABEB,
+		0xB505, 0xBDAF, 0xC5E4, 0xCD9F, 0xD4DB, 0xDB94, 0xE1C6, 0xE76C,
+		0xEC83, 0xF109, 0xF4FA, 0xF854, 0xFB15, 0xFD3B, 0xFEC4, 0xFFB1,
+		0xFFFF
+	};
+#elif FPINT_SIN_TABLESIZE == 64
+	#define SIN_TABLE_SCALE 0x28BE61L
+	static const unsigned short sin_table[FPINT_SIN_TABLESIZE + 1] = {
+		0x0000, 0x0648, 0x0C90, 0x12D5, 0x1918, 0x1F56, 0x2590, 0x2BC4,
+		0x31F1, 0x3817, 0x3E34, 0x4447, 0x4A50, 0x504D, 0x563E, 0x5C22,
+		0x61F8, 0x67BE, 0x6D74, 0x731A, 0x78AD, 0x7E2F, 0x839C, 0x88F6,
+		0x8E3A, 0x9368, 0x9880, 0x9D80, 0xA268, 0xA736, 0xABEB, 0xB086,
+		0xB505, 0xB968, 0xBDAF, 0xC1D8, 0xC5E4, 0xC9D1, 0xCD9F, 0xD14D,
+		0xD4DB, 0xD848, 0xDB94, 0xDEBE, 0xE1C6, 0xE4AA, 0xE76C, 0xEA0A,
+		0xEC83, 0xEED9, 0xF109, 0xF314, 0xF4FA, 0xF6BA, 0xF854, 0xF9C8,
+		0xFB15, 0xFC3B, 0xFD3B, 0xFE13, 0xFEC4, 0xFF4E, 0xFFB1, 0xFFEC,
+		0xFFFF
+	};
+#elif FPINT_SIN_TABLESIZE == 128
+	#define SIN_TABLE_SCALE 0x517CC2L
+	static const unsigned short sin_table[FPINT_SIN_TABLESIZE + 1] = {
+		0x0000, 0x0324, 0x0648, 0x096C, 0x0C90, 0x0FB3, 0x12D5, 0x15F7,
+		0x1918, 0x1C38, 0x1F56, 0x2274, 0x2590, 0x28AB, 0x2BC4, 0x2EDC,
+		0x31F1, 0x3505, 0x3817, 0x3B27, 0x3E34, 0x413F, 0x4447, 0x474D,
+		0x4A50, 0x4D50, 0x504D, 0x5348, 0x563E, 0x5932, 0x5C22, 0x5F0F,
+		0x61F8, 0x64DD, 0x67BE, 0x6A9B, 0x6D74, 0x7049, 0x731A, 0x75E6,
+		0x78AD, 0x7B70, 0x7E2F, 0x80E8, 0x839C, 0x864C, 0x88F6, 0x8B9A,
+		0x8E3A, 0x90D4, 0x9368, 0x95F7, 0x9880, 0x9B03, 0x9D80, 0x9FF7,
+		0xA268, 0xA4D2, 0xA736, 0xA994, 0xABEB, 0xAE3C, 0xB086, 0xB2C9,
+		0xB505, 0xB73A, 0xB968, 0xBB8F, 0xBDAF, 0xBFC7, 0xC1D8, 0xC3E2,
+		0xC5E4, 0xC7DE, 0xC9D1, 0xCBBC, 0xCD9F, 0xCF7A, 0xD14D, 0xD318,
+		0xD4DB, 0xD696, 0xD848, 0xD9F2, 0xDB94, 0xDD2D, 0xDEBE, 0xE046,
+		0xE1C6, 0xE33C, 0xE4AA, 0xE610, 0xE76C, 0xE8BF, 0xEA0A, 0xEB4B,
+		0xEC83, 0xEDB3, 0xEED9, 0xEFF5, 0xF109, 0xF213, 0xF314, 0xF40C,
+		0xF4FA, 0xF5DF, 0xF6BA, 0xF78C, 0xF854, 0xF913, 0xF9C8, 0xFA73,
+		0xFB15, 0xFBAD, 0xFC3B, 0xFCC0, 0xFD3B, 0xFDAC, 0xFE13, 0xFE71,
+		0xFEC4, 0xFF0E, 0xFF4E, 0xFF85, 0xFFB1, 0xFFD4, 0xFFEC, 0xFFFB,
+		0xFFFF
+	};
+#elif FPINT_SIN_TABLESIZE == 256
+	#define SIN_TABLE_SCALE 0xA2F983L
+	static const unsigned short sin_table[FPINT_SIN_TABLESIZE + 1] = {
+		0x0000, 0x0192, 0x0324, 0x04B6, 0x0648, 0x07DA, 0x096C, 0x0AFE,
+		0x0C90, 0x0E21, 0x0FB3, 0x1144, 0x12D5, 0x1466, 0x15F7, 0x1787,
+		0x1918, 0x1AA8, 0x1C38, 0x1DC7, 0x1F56, 0x20E5, 0x2274, 0x2402,
+		0x2590, 0x271E, 0x28AB, 0x2A38, 0x2BC4, 0x2D50, 0x2EDC, 0x3067,
+		0x31F1, 0x337C, 0x3505, 0x368E, 0x3817, 0x399F, 0x3B27, 0x3CAE,
+		0x3E34, 0x3FBA, 0x413F, 0x42C3, 0x4447, 0x45CB, 0x474D, 0x48CF,
+		0x4A50, 0x4BD1, 0x4D50, 0x4ECF, 0x504D, 0x51CB, 0x5348, 0x54C3,
+		0x563E, 0x57B9, 0x5932, 0x5AAA, 0x5C22, 0x5D99, 0x5F0F, 0x6084,
+		0x61F8, 0x636B, 0x64DD, 0x664E, 0x67BE, 0x692D, 0x6A9B, 0x6C08,
+		0x6D74, 0x6EDF, 0x7049, 0x71B2, 0x731A, 0x7480, 0x75E6, 0x774A,
+		0x78AD, 0x7A10, 0x7B70, 0x7CD0, 0x7E2F, 0x7F8C, 0x80E8, 0x8243,
+		0x839C, 0x84F5, 0x864C, 0x87A1, 0x88F6, 0x8A49, 0x8B9A, 0x8CEB,
+		0x8E3A, 0x8F88, 0x90D4, 0x921F, 0x9368, 0x94B0, 0x95F7, 0x973C,
+		0x9880, 0x99C2, 0x9B03, 0x9C42, 0x9D80, 0x9EBC, 0x9FF7, 0xA130,
+		0xA268, 0xA39E, 0xA4D2, 0xA605, 0xA736, 0xA866, 0xA994, 0xAAC1,
+		0xABEB, 0xAD14, 0xAE3C, 0xAF62, 0xB086, 0xB1A8, 0xB2C9, 0xB3E8,
+		0xB505, 0xB620, 0xB73A, 0xB852, 0xB968, 0xBA7D, 0xBB8F, 0xBCA0,
+		0xBDAF, 0xBEBC, 0xBFC7, 0xC0D1, 0xC1D8, 0xC2DE, 0xC3E2, 0xC4E4,
+		0xC5E4, 0xC6E2, 0xC7DE, 0xC8D9, 0xC9D1, 0xCAC7, 0xCBBC, 0xCCAE,
+		0xCD9F, 0xCE8E, 0xCF7A, 0xD065, 0xD14D, 0xD234, 0xD318, 0xD3FB,
+		0xD4DB, 0xD5BA, 0xD696, 0xD770, 0xD848, 0xD91E, 0xD9F2, 0xDAC4,
+		0xDB94, 0xDC62, 0xDD2D, 0xDDF7, 0xDEBE, 0xDF83, 0xE046, 0xE107,
+		0xE1C6, 0xE282, 0xE33C, 0xE3F4, 0xE4AA, 0xE55E, 0xE610, 0xE6BF,
+		0xE76C, 0xE817, 0xE8BF, 0xE966, 0xEA0A, 0xEAAB, 0xEB4B, 0xEBE8,
+		0xEC83, 0xED1C, 0xEDB3, 0xEE47, 0xEED9, 0xEF68, 0xEFF5, 0xF080,
+		0xF109, 0xF18F, 0xF213, 0xF295, 0xF314, 0xF391, 0xF40C, 0xF484,
+		0xF4FA, 0xF56E, 0xF5DF, 0xF64E, 0xF6BA, 0xF724, 0xF78C, 0xF7F1,
+		0xF854, 0xF8B4, 0xF913, 0xF96E, 0xF9C8, 0xFA1F, 0xFA73, 0xFAC5,
+		0xFB15, 0xFB62, 0xFBAD, 0xFBF5, 0xFC3B, 0xFC7F, 0xFCC0, 0xFCFE,
+		0xFD3B, 0xFD74, 0xFDAC, 0xFDE1, 0xFE13, 0xFE43, 0xFE71, 0xFE9C,
+		0xFEC4, 0xFEEB, 0xFF0E, 0xFF30, 0xFF4E, 0xFF6B, 0xFF85, 0xFF9C,
+		0xFFB1, 0xFFC4, 0xFFD4, 0xFFE1, 0xFFEC, 0xFFF5, 0xFFFB, 0xFFFF,
+		0xFFFF
+	};
+#else
+	#error FPINT_SIN_TABLESIZE has to be 16, 32, 64, 128 or 256
+#endif
+
+/**
+ * reciprocal of PI for reducing angles
+ */
+static const fpint_reciprocal reciprocal_pi = FPINT_RECIPROCAL(FPINT_PI);
+
+/**
+ * sine by linear interpolation of a quarter wave table
+ */
 fpint fpint_sin(fpint x) {
-    int factor = 1;
+    int negative = 0;
 
     // mirror sine of x < 0 to x > 0
     if(x < 0) {
         x = fpint_abs(x);
-        factor *= -1;
+        negative = !negative;
     }
 
     // move x to PI-Interval [0, PI]
     if(x > FPINT_PI) {
-    	// space-efficient fixed integer calculations:
-    	if((x / FPINT_PI) % 2 == 1)
-    		factor *= -1;
-    	x %= FPINT_PI;
+    	unsigned long halfwaves = fpint_udiv_reciprocal(x, &reciprocal_pi);
+    	if(halfwaves % 2 == 1)
+    		negative = !negative;
+    	x -= halfwaves * FPINT_PI;
     }
 
-    /*
-     * Sine:
-     */
-    fpint fp_xit = x;
-    fpint fp_sum = 0;
-    fpint a = 0x099FL, b = 0x3C71L, c = 0x0EECL, d = 0xFB62; // a*x^4 - b*x^3 + c*x^2 + d*x
-
-    // Polynom 4
-    fp_sum = fpint_mul(d, fp_xit);
-    // Polynom 3
-    fp_xit = fpint_mul(fp_xit, x);
-    fp_sum = fpint_add(fp_sum, fpint_mul(c, fp_xit));
-    // Polynom 2
-    fp_xit = fpint_mul(fp_xit, x);
-    fp_sum = fpint_sub(fp_sum, fpint_mul(b, fp_xit));
-    // Polynom 1
-    fp_xit = fpint_mul(fp_xit, x);
-    fp_sum = fpint_add(fp_sum, fpint_mul(a, fp_xit));
+    // move x to quarter wave [0, PI/2]
+    if(x > (FPINT_PI >> 1))
+    	x = fpint_sub(FPINT_PI, x);
+
+    // interpolate between table values
+    fpint pos = fpint_mul(x, SIN_TABLE_SCALE);
+    int i = fpint_from(pos);
+    fpint fp_sin;
+    if(i >= FPINT_SIN_TABLESIZE) {
+    	fp_sin = FPINT_ONE;
+    } else {
+    	unsigned short fraction = (unsigned short) (pos & 0xFFFF);
+    	fp_sin = sin_table[i] + (fpint) ((umul16(sin_table[i + 1] - sin_table[i], fraction) + 0x8000) >> 16);
+    }
 
-    return fpint_mul(fp_sum, fpint_to(factor));
+    return negative ? fpint_sub(FPINT_ZERO, fp_sin) : fp_sin;
 }
 
 fpint fpint_cos(fpint x) {
@@ -159,7 +375,7 @@ fpint fpint_quantile(const fpint* set, int count, fpint q) {
 	// calculate average
 	fpint avg = fpint_avg(set, count);
 
-	// calculate standard derivation
+	// calculate standard deviation
 	fpint stdev = fpint_to(0);
 	int i;
 	for(i = 0; i < count; i++) {
@@ -172,9 +388,51 @@ fpint fpint_quantile(const fpint* set, int count, fpint q) {
 	return fpint_add(fpint_mul(q, stdev), avg);
 }
 
+/**
+ * digit-by-digit square root (binary restoring method) with rounding
+ *
+ * sqrt(a) in Q15.16 is sqrt(a * 2^16) as integer, so 24 result bits are
+ * needed: 16 are calculated from the 32 bit value, then the remainder is
+ * shifted by 16 bits for the last 8 result bits. Runs always in 24 steps of
+ * shifts, adds and compares (no division, no 64 bit arithmetic).
+ */
 fpint fpint_sqrt(fpint a) {
-	fpint epsilon = 0x0021; // ~0.0005
-	return fpint_sqrt_epsilon(a, epsilon);
+	if(a < FPINT_ZERO)
+		return FPINT_MINUSONE;
+
+	unsigned long remainder = (unsigned long) a, root = 0, bit = 1UL << 30;
+	int pass;
+	for(pass = 0; pass < 2; pass++) {
+		while(bit > 0) {
+			if(remainder >= root + bit) {
+				remainder -= root + bit;
+				root = (root >> 1) + bit;
+			} else {
+				root >>= 1;
+			}
+			bit >>= 2;
+		}
+
+		if(pass == 0) {
+			// shift remainder and root by 16 bit for the next 8 result bits
+			// (remainder >= 2^16 would overflow, so root is preset to root + 0.5:
+			//  remainder - (root + 0.5)^2 + root^2 = remainder - root - 0.25)
+			if(remainder > 0xFFFF) {
+				remainder = ((remainder - root) << 16) - 0x4000;
+				root = (root << 16) + 0x8000;
+			} else {
+				remainder <<= 16;
+				root <<= 16;
+			}
+			bit = 1UL << 14;
+		}
+	}
+
+	// round up when next result bit would be set
+	if(remainder > root)
+		root++;
+
+	return (fpint) root;
 }
 
 /**
@@ -5,8 +5,10 @@
 
 /**
  * Q15.16 floating point integers
+ *
+ * (int32_t is long on msp430, but keeps fpint 32 bit wide on 64 bit hosts)
  */
-typedef long fpint;
+typedef int32_t fpint;
 
 /**
  * fpint constants
@@ -56,9 +58,18 @@ char* fpint_str(fpint a, char* buf);
 
 /**
  * multiply one fpint with another
+ *
+ * (widening 32x32 bit multiplication without 64 bit arithmetic)
  */
 fpint fpint_mul(fpint a, fpint b);
 
+/**
+ * multiply one fpint with another without overflow
+ *
+ * returns full product as Q47.16
+ */
+long long fpint_mul_wide(fpint a, fpint b);
+
 /**
  * multiply one fpint multiple times
  */
@@ -69,6 +80,41 @@ fpint fpint_multimes(fpint a, unsigned long times);
  */
 fpint fpint_div(fpint a, fpint b);
 
+/**
+ * precomputed reciprocal of a constant integer divisor
+ *
+ * divisions by constants (e.g. from sdf-config.h) can be replaced by a
+ * multiplication and a small correction instead of a 64 bit software division
+ */
+typedef struct {
+	unsigned long divisor;
+	unsigned long multiplier;
+} fpint_reciprocal;
+
+/**
+ * initializer of an fpint_reciprocal, constant folded by the compiler
+ *
+ * static const fpint_reciprocal r = FPINT_RECIPROCAL(SPEEDMULTIPLIER);
+ */
+#define FPINT_RECIPROCAL(divisor) { (unsigned long) (divisor), 0xFFFFFFFFUL / (unsigned long) (divisor) }
+
+/**
+ * sets an fpint_reciprocal for a divisor known at runtime only
+ */
+void fpint_reciprocal_set(fpint_reciprocal* r, unsigned long divisor);
+
+/**
+ * divides one fpint by an integer with precomputed reciprocal
+ *
+ * (equal to fpint_div(a, fpint_to(r->divisor)))
+ */
+fpint fpint_div_reciprocal(fpint a, const fpint_reciprocal* r);
+
+/**
+ * divides an unsigned long by an integer with precomputed reciprocal
+ */
+unsigned long fpint_udiv_reciprocal(unsigned long a, const fpint_reciprocal* r);
+
 /**
  * floor an fpint
  */
@@ -121,11 +167,15 @@ fpint fpint_quantile(const fpint* set, int count, fpint q);
 
 /**
  * calculates square root of a number
+ *
+ * (exactly rounded, in a fixed number of steps)
  */
 fpint fpint_sqrt(fpint a);
 
 /**
  * calculates square root of a number
+ *
+ * (Newton's method until precision epsilon is reached)
  */
 fpint fpint_sqrt_epsilon(fpint a, fpint epsilon);
 
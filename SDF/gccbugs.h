@@ -9,7 +9,7 @@
  *
  * gccbugs_ulldiv() and gccbugs_lldiv() are fixing incorrect division results
  * gccbugs_ullmul() and gccbugs_llmul() preventing gcc compiler from inlining small
- *   function bodies using 64 bit multiplication (e.g. fpint_mul)
+ *   function bodies using 64 bit multiplication
  */
 
 /**
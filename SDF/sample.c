@@ -0,0 +1,39 @@
+#include "sample.h"
+#include "byteorder.h"
+
+int sample_encode(const sample* samples, int count, uint8_t* buffer) {
+	uint8_t* pos = buffer;
+	*pos++ = SAMPLE_VERSION;
+	*pos++ = count;
+
+	const sample* s;
+	for(s = samples; s < samples + count; s++) {
+		pos = byteorder_put16(pos, s->node);
+		pos = byteorder_put16(pos, s->sequence);
+		pos = byteorder_put16(pos, s->co);
+		pos = byteorder_put16(pos, s->co2);
+		pos = byteorder_put32(pos, s->latitude);
+		pos = byteorder_put32(pos, s->longitude);
+		*pos++ = s->battery;
+	}
+
+	return pos - buffer;
+}
+
+int sample_count(const uint8_t* buffer, uint16_t length) {
+	if(length < SAMPLE_HEADER_SIZE || buffer[0] != SAMPLE_VERSION || length < SAMPLE_MESSAGE_SIZE(buffer[1]))
+		return 0;
+
+	return buffer[1];
+}
+
+void sample_decode(sample* s, const uint8_t* buffer, int pos) {
+	buffer += SAMPLE_MESSAGE_SIZE(pos);
+	s->node      = byteorder_get16(buffer);
+	s->sequence  = byteorder_get16(buffer + 2);
+	s->co        = byteorder_get16(buffer + 4);
+	s->co2       = byteorder_get16(buffer + 6);
+	s->latitude  = byteorder_get32(buffer + 8);
+	s->longitude = byteorder_get32(buffer + 12);
+	s->battery   = buffer[16];
+}
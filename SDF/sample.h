@@ -0,0 +1,67 @@
+#ifndef SAMPLE_H_
+#define SAMPLE_H_
+
+#include <stdint.h>
+
+#include "fpint.h"
+
+/**
+ * version of binary sample payload (first byte of every message)
+ */
+#define SAMPLE_VERSION 3
+
+/**
+ * size of message header in bytes
+ *
+ * version (1), number of samples (1)
+ */
+#define SAMPLE_HEADER_SIZE 2
+
+/**
+ * size of an encoded sample in bytes
+ *
+ * node (2), sequence (2), co (2), co2 (2), latitude (4), longitude (4), battery (1)
+ */
+#define SAMPLE_SIZE 17
+
+/**
+ * size of a message with count samples in bytes
+ */
+#define SAMPLE_MESSAGE_SIZE(count) (SAMPLE_HEADER_SIZE + (count) * SAMPLE_SIZE)
+
+/**
+ * sensor sample of a mote
+ *
+ * (node is the last 16bits of the mote's ipv6 address, samples of
+ * several motes may be aggregated into one message by forwarding motes)
+ */
+typedef struct {
+	uint16_t node;
+	uint16_t sequence;
+	uint16_t co;
+	uint16_t co2;
+	fpint latitude;
+	fpint longitude;
+	uint8_t battery;
+} sample;
+
+/**
+ * encodes a message of count samples into buffer (at least SAMPLE_MESSAGE_SIZE(count) bytes)
+ *
+ * returns number of bytes written
+ */
+int sample_encode(const sample* samples, int count, uint8_t* buffer);
+
+/**
+ * number of samples in a message
+ *
+ * returns 0 for an invalid message
+ */
+int sample_count(const uint8_t* buffer, uint16_t length);
+
+/**
+ * decodes sample at position pos (0 to sample_count() - 1) of a valid message
+ */
+void sample_decode(sample* s, const uint8_t* buffer, int pos);
+
+#endif /* SAMPLE_H_ */
@@ -2,78 +2,142 @@
 
 #include "sdf-config.h"
 #include "fpint.h"
-#include "energymeter.h"
+#include "energyledger.h"
 #include "samplingrate.h"
 #include "circularbuffer.h"
 #include "consumptionrate.h"
+#include "battery.h"
 #include "udphelper.h"
 #include "gccbugs.h"
 
 #define DEBUG DEBUG_OFF
 #include "debug.h"
 
+/**
+ * reciprocal of speed multiplier
+ */
+static const fpint_reciprocal reciprocal_speedmultiplier = FPINT_RECIPROCAL(SPEEDMULTIPLIER);
+
+/**
+ * reciprocal of samples sent in a single message
+ */
+static const fpint_reciprocal reciprocal_batch = FPINT_RECIPROCAL(SDF_SAMPLINGRATE_BATCH);
+
 /**
  * samples of energy drain for radio transmiting a message
  */
-static fpint tx_samples[SDF_SAMPLINGRATE_ENERGYSAMPLES];
-static int   tx_nextpos = 0, tx_saved = 0;
+CIRCULARBUFFER_STATS(tx_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES);
 
 /**
  * samples of energy drain for radio receiving a message
  */
-static fpint rx_samples[SDF_SAMPLINGRATE_ENERGYSAMPLES];
-static int   rx_nextpos = 0, rx_saved = 0;
+CIRCULARBUFFER_STATS(rx_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES);
 
 /**
  * samples of energy drain for sensing values for a single message
  */
-static fpint sense_samples[SDF_SAMPLINGRATE_ENERGYSAMPLES];
-static int   sense_nextpos = 0, sense_saved = 0;
+CIRCULARBUFFER_STATS(sense_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES);
+
+/**
+ * position in energy ledger of last energy drain sample
+ */
+static energyledger_cursor cursor;
+
+/**
+ * whether an energy drain sample has already been taken
+ */
+static int energy_sample_taken = 0;
+
+#if SDF_SAMPLINGRATE_CONTROLLER == SDF_SAMPLINGRATE_CONTROLLER_BATTERY
+
+/**
+ * integrated difference of battery capacity to target capacity (advanced once per interval)
+ */
+static fpint fp_battery_integral = 0;
+
+/**
+ * difference of battery capacity to target capacity
+ */
+static fpint battery_error() {
+	fpint fp_target = fpint_mul(battery_maxcapacity(), (fpint) (SDF_SAMPLINGRATE_BATTERY_TARGET * FPINT_ONE / 100));
+	return fpint_sub(battery_capacity(), fp_target);
+}
 
 /**
- * last energymeter sample
+ * integrates difference to battery target level of an interval
  */
-static energymeter_sample last_energymeter_sample;
+static void battery_integrate() {
+	// integral is bounded by battery capacity to prevent windup
+	fpint fp_maxcapacity = battery_maxcapacity();
+	fp_battery_integral = fpint_add(fp_battery_integral, battery_error());
+	fp_battery_integral = fpint_max(fpint_min(fp_battery_integral, fp_maxcapacity), -fp_maxcapacity);
+}
 
 /**
- * whether an energymeter sample has already been taken
+ * energy to add to (or remove from) energy neutral consumption for heading to battery target level
  */
-static int energymeter_sample_taken = 0;
+static fpint battery_correction() {
+	fpint fp_error      = battery_error();
+	fpint fp_correction = fpint_add(fpint_mul(fp_error, SDF_SAMPLINGRATE_BATTERY_KP), fpint_mul(fp_battery_integral, SDF_SAMPLINGRATE_BATTERY_KI));
+	debug("[SAMPLINGRATE] battery-error=%smAh ", debug_fpint(fp_error));
+	debug("correction=%smAh\n",                  debug_fpint(fp_correction));
+
+	return fp_correction;
+}
+
+#endif
 
 /**
- * calculte drain of a soure
+ * energy available for next interval
  */
-static fpint drain(unsigned long long* last, unsigned long long* now, fpint fp_energy) {
-	fpint fp_drain;
+static fpint energy_available() {
+	fpint fp_energy = consumptionrate_energy(SDF_SAMPLINGRATE_UPDATEINTERVAL);
+	#if SDF_SAMPLINGRATE_CONTROLLER == SDF_SAMPLINGRATE_CONTROLLER_BATTERY
+		// harvest which would overflow a full battery is spent, an empty battery only gets minimal sampling rate
+		fp_energy = fpint_max(FPINT_ZERO, fpint_add(fp_energy, battery_correction()));
+		if(battery_level() < SDF_SAMPLINGRATE_BATTERY_FLOOR)
+			fp_energy = FPINT_ZERO;
+	#endif
 
-	energymeter_drain_seconds(last, now, fp_energy, &fp_drain, ENERGYMETER_DRAIN_WITH_INCOMPLETE_TIMEFRAMES);
-	return fp_drain;
+	return fp_energy;
+}
+
+/**
+ * sampling rate for messages bounded by maximum and minimal sampling rate
+ */
+static int samplingrate_bounded(fpint fp_messages, int max_messages) {
+	int samplingrate = fpint_from(fpint_floor(fp_messages));
+	if(max_messages != -1 && samplingrate > max_messages)
+		samplingrate = max_messages;
+	int min_samplingrate = fpint_from(fpint_round(fpint_div_reciprocal(fpint_to(SDF_SAMPLINGRATE_MINIMAL), &reciprocal_speedmultiplier)));
+	if(samplingrate < min_samplingrate)
+		samplingrate = min_samplingrate;
+
+	return samplingrate;
 }
 
 int samplingrate_calculate(int max_messages) {
 	// average energy needed for operations
-	fpint fp_energy_rx    = fpint_avg(rx_samples,    rx_saved);
-	fpint fp_energy_tx    = fpint_avg(tx_samples,    tx_saved);
-	fpint fp_energy_sense = fpint_avg(sense_samples, sense_saved);
+	fpint fp_energy_rx    = circularbuffer_stats_avg(&rx_samples);
+	fpint fp_energy_tx    = circularbuffer_stats_avg(&tx_samples);
+	fpint fp_energy_sense = circularbuffer_stats_avg(&sense_samples);
 
 	// available energy
-	fpint fp_energy = consumptionrate_energy(SDF_SAMPLINGRATE_UPDATEINTERVAL);
+	fpint fp_energy = energy_available();
 
 	// get child count
-	fpint fp_childs = fpint_to(udphelper_childs_all_count());
+	fpint fp_childs = fpint_to(samplingrate_childs());
 
-	// calculate messages
+	// calculate messages (radio drain is shared by all samples of a message)
+	// (samples of childs are received and forwarded in batches. SDF_AGGREGATION only merges
+	// incomplete batches, saving at most a message per mote and interval, which is not modeled)
 	fpint fp_drain_childs = fpint_mul(fp_childs, fpint_add(fp_energy_rx, fp_energy_tx));
-	fpint fp_drain_self   = fpint_add(fp_energy_tx, fp_energy_sense);
-	fpint fp_messages     = fpint_div(fp_energy, fpint_add(fp_drain_childs, fp_drain_self));
+	fpint fp_drain_radio  = fpint_div_reciprocal(fpint_add(fp_drain_childs, fp_energy_tx), &reciprocal_batch);
+	fpint fp_drain_sample = fpint_add(fp_drain_radio, fp_energy_sense);
+	fpint fp_messages     = fpint_div(fp_energy, fp_drain_sample);
 
 	// set sampling rate
-	int samplingrate = fpint_from(fpint_floor(fp_messages));
-	if(max_messages != -1 && samplingrate > max_messages)
-		samplingrate = max_messages;
-	int min_samplingrate = fpint_from(fpint_round(fpint_div(fpint_to(SDF_SAMPLINGRATE_MINIMAL), fpint_to(SPEEDMULTIPLIER))));
-	if(samplingrate < min_samplingrate)
-		samplingrate = min_samplingrate;
+	int samplingrate = samplingrate_bounded(fp_messages, max_messages);
 
 	// debug calculation results
 	debug("[SAMPLINGRATE] ");
@@ -81,7 +145,7 @@ int samplingrate_calculate(int max_messages) {
 	debug("avg-transmit=%smAh ",     debug_fpint(fp_energy_tx));
 	debug("avg-sensors=%smAh ",      debug_fpint(fp_energy_sense));
 	debug("available-energy=%smAh ", debug_fpint(fp_energy));
-	debug("childs=%d ",              udphelper_childs_all_count());
+	debug("childs=%d ",              samplingrate_childs());
 	debug("messages=%s ",            debug_fpint(fp_messages));
 	debug("max-messages=%d | ",      max_messages);
 	debug("samplingrate=%d\n",       samplingrate);
@@ -89,37 +153,125 @@ int samplingrate_calculate(int max_messages) {
 	return samplingrate;
 }
 
-void samplingrate_sample_energy_drain(int last_samplingrate, int last_childcount) {
-	// sample actual energy
-	static energymeter_sample now;
-	energymeter_sampling(&now);
+#if SDF_SAMPLINGRATE_ALLOCATION
 
+fpint samplingrate_waterfill(fpint fp_energy, fpint fp_drain_self, fpint fp_drain_child, int max_messages, const samplingrate_demand* sorted, int count) {
+	// water-filling: demands below the equal share of remaining energy are satisfied,
+	// their unused share is distributed to the remaining childs and the mote itself
+	// (a child drains energy for the samples of all motes of its subtree)
+	int i;
+	fpint fp_drain = fp_drain_self;
+	for(i = 0; i < count; i++)
+		fp_drain = fpint_add(fp_drain, fpint_mul(fpint_to(sorted[i].motes), fp_drain_child));
+	fpint fp_level = fpint_div(fp_energy, fp_drain);
+	int self_satisfied = 0;
+	i = 0;
+	while(!self_satisfied || i < count) {
+		// smallest demand not yet satisfied
+		int self_next = !self_satisfied && max_messages != -1 && (i == count || max_messages <= sorted[i].samplingrate);
+		int demand = self_next ? max_messages : (i < count ? sorted[i].samplingrate : -1);
+		if(demand == -1 || fpint_to(demand) > fp_level)
+			break;
+
+		fpint fp_drain_participant = self_next ? fp_drain_self : fpint_mul(fpint_to(sorted[i].motes), fp_drain_child);
+		fp_energy = fpint_sub(fp_energy, fpint_mul(fpint_to(demand), fp_drain_participant));
+		fp_drain  = fpint_sub(fp_drain, fp_drain_participant);
+		if(self_next)
+			self_satisfied = 1;
+		else
+			i++;
+
+		// all demands satisfied: childs are not limited
+		if(fp_drain <= 0)
+			return FPINT_MAX;
+		fp_level = fpint_div(fpint_max(FPINT_ZERO, fp_energy), fp_drain);
+	}
+
+	return fp_level;
+}
+
+int samplingrate_allocate(int max_messages, const samplingrate_demand* demands, int count, int* demand) {
+	// energy needed for an own sample and for receiving and forwarding a sample of a child
+	fpint fp_energy_rx    = circularbuffer_stats_avg(&rx_samples);
+	fpint fp_energy_tx    = circularbuffer_stats_avg(&tx_samples);
+	fpint fp_energy_sense = circularbuffer_stats_avg(&sense_samples);
+	fpint fp_drain_self   = fpint_add(fpint_div_reciprocal(fp_energy_tx, &reciprocal_batch), fp_energy_sense);
+	fpint fp_drain_child  = fpint_div_reciprocal(fpint_add(fp_energy_rx, fp_energy_tx), &reciprocal_batch);
+
+	// childs sorted by demand
+	static samplingrate_demand sorted[SDF_SAMPLINGRATE_ALLOCATION_CHILDS];
+	int i, j;
+	if(count > SDF_SAMPLINGRATE_ALLOCATION_CHILDS)
+		count = SDF_SAMPLINGRATE_ALLOCATION_CHILDS;
+	for(i = 0; i < count; i++) {
+		for(j = i; j > 0 && sorted[j - 1].samplingrate > demands[i].samplingrate; j--)
+			sorted[j] = sorted[j - 1];
+		sorted[j] = demands[i];
+	}
+
+	// the mote itself has no demand and gets the level, achievable sampling rate without limit
+	// of parent is reported as demand (the parent forwards the samples of the whole subtree at
+	// most at its limit, so the same limit applies to the mote and its childs)
+	fpint fp_level = samplingrate_waterfill(energy_available(), fp_drain_self, fp_drain_child, -1, sorted, count);
+	*demand = samplingrate_bounded(fp_level, -1);
+	int samplingrate = samplingrate_bounded(fp_level, max_messages);
+
+	debug("[SAMPLINGRATE] allocation childs=%d ", count);
+	debug("level=%s ",                            debug_fpint(fp_level));
+	debug("demand=%d ",                           *demand);
+	debug("samplingrate=%d\n",                    samplingrate);
+
+	return samplingrate;
+}
+
+#endif
+
+fpint samplingrate_energy() {
+	return energy_available();
+}
+
+int samplingrate_forwardable(fpint fp_energy, int motes) {
+	fpint fp_energy_rx = circularbuffer_stats_avg(&rx_samples);
+	fpint fp_energy_tx = circularbuffer_stats_avg(&tx_samples);
+	fpint fp_drain     = fpint_mul(fpint_to(motes), fpint_div_reciprocal(fpint_add(fp_energy_rx, fp_energy_tx), &reciprocal_batch));
+	if(fp_drain <= 0)
+		return -1;
+
+	return samplingrate_bounded(fpint_div(fp_energy, fp_drain), -1);
+}
+
+int samplingrate_childs() {
+	return udphelper_childs_all_count();
+}
+
+void samplingrate_sample_energy_drain(int last_samplingrate, int last_childcount) {
 	// prevent calculation for first interval: no last sample is available
-	if(energymeter_sample_taken) {
-		// last sampling rate as fpint
+	if(energy_sample_taken) {
+		// last sampling rate and messages sent for it as fpint
 		fpint fp_lastsamplingrate = fpint_to(last_samplingrate);
+		fpint fp_lastmessages     = fpint_to((last_samplingrate + SDF_SAMPLINGRATE_BATCH - 1) / SDF_SAMPLINGRATE_BATCH);
 
 		// calc tx drain
-		fpint fp_transmitted    = fpint_add(fp_lastsamplingrate, fpint_mul(fp_lastsamplingrate, fpint_to(last_childcount)));
-		fpint fp_drain_transmit = fpint_div(drain(&last_energymeter_sample.radio_transmit, &now.radio_transmit, ENERGYMETER_DRAIN_SECONDS_RADIO_TRANSMIT), fp_transmitted);
-		circularbuffer_save(tx_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES, fp_drain_transmit, &tx_nextpos, &tx_saved);
+		fpint fp_transmitted    = fpint_add(fp_lastmessages, fpint_mul(fp_lastmessages, fpint_to(last_childcount)));
+		fpint fp_drain_transmit = fpint_div(energyledger_drain(&cursor, ENERGYLEDGER_RADIO_TRANSMIT), fp_transmitted);
+		circularbuffer_stats_save(&tx_samples, fp_drain_transmit);
 
 		// calc rx drain
 		fpint fp_drain_receive;
 		if(last_childcount > 0) {
-			fpint fp_received = fpint_mul(fp_lastsamplingrate, fpint_to(last_childcount));
-			fp_drain_receive  = fpint_div(drain(&last_energymeter_sample.radio_listen, &now.radio_listen, ENERGYMETER_DRAIN_SECONDS_RADIO_LISTEN), fp_received);
-			circularbuffer_save(rx_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES, fp_drain_receive, &rx_nextpos, &rx_saved);
+			fpint fp_received = fpint_mul(fp_lastmessages, fpint_to(last_childcount));
+			fp_drain_receive  = fpint_div(energyledger_drain(&cursor, ENERGYLEDGER_RADIO_LISTEN), fp_received);
+			circularbuffer_stats_save(&rx_samples, fp_drain_receive);
 		} else {
 			fp_drain_receive = FPINT_ZERO;
 		}
 
 		// calc sensor drains
-		fpint fp_drain_co    = drain(&last_energymeter_sample.sensor_co,  &now.sensor_co,  ENERGYMETER_DRAIN_SECONDS_SENSOR_CO);
-		fpint fp_drain_co2   = drain(&last_energymeter_sample.sensor_co2, &now.sensor_co2, ENERGYMETER_DRAIN_SECONDS_SENSOR_CO2);
-		fpint fp_drain_gps   = drain(&last_energymeter_sample.sensor_gps, &now.sensor_gps, ENERGYMETER_DRAIN_SECONDS_SENSOR_GPS);
+		fpint fp_drain_co    = energyledger_drain(&cursor, ENERGYLEDGER_SENSOR_CO);
+		fpint fp_drain_co2   = energyledger_drain(&cursor, ENERGYLEDGER_SENSOR_CO2);
+		fpint fp_drain_gps   = energyledger_drain(&cursor, ENERGYLEDGER_SENSOR_GPS);
 		fpint fp_drain_sense = fpint_div(fpint_add(fp_drain_co, fpint_add(fp_drain_co2, fp_drain_gps)), fp_lastsamplingrate);
-		circularbuffer_save(sense_samples, SDF_SAMPLINGRATE_ENERGYSAMPLES, fp_drain_sense, &sense_nextpos, &sense_saved);
+		circularbuffer_stats_save(&sense_samples, fp_drain_sense);
 
 		// uncomment code block if you're really interested in (saved firmware size can be used for other debugging purposes)
 		//debug("[SAMPLINGRATE] samplingrate=%d | ", last_samplingrate);
@@ -130,7 +282,12 @@ void samplingrate_sample_energy_drain(int last_samplingrate, int last_childcount
 		//debug("gps=%smAh\n",     debug_fpint(fp_drain_gps));
 	}
 
+	// battery controller integrates once per interval (not per calculation of samplingrate)
+	#if SDF_SAMPLINGRATE_CONTROLLER == SDF_SAMPLINGRATE_CONTROLLER_BATTERY
+		battery_integrate();
+	#endif
+
 	// save actual sample as last sample
-	memcpy(&last_energymeter_sample, &now, sizeof(energymeter_sample));
-	energymeter_sample_taken = 1;
+	energyledger_cursor_advance(&cursor);
+	energy_sample_taken = 1;
 }
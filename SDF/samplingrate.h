@@ -1,13 +1,70 @@
 #ifndef SAMPLINGRATE_H_
 #define SAMPLINGRATE_H_
 
+/**
+ * controllers of sampling rate (SDF_SAMPLINGRATE_CONTROLLER)
+ */
+#define SDF_SAMPLINGRATE_CONTROLLER_NEUTRAL 0
+#define SDF_SAMPLINGRATE_CONTROLLER_BATTERY 1
+
 /**
  * calculates the sampling rate for an interval
  */
 int samplingrate_calculate(int max_messages);
 
+/**
+ * demand of a direct child (SDF_SAMPLINGRATE_ALLOCATION)
+ *
+ * samplingrate is the sampling rate achievable by the child, motes the number of
+ * motes sampling in the subtree of the child (child included) whose samples are
+ * received and forwarded
+ */
+typedef struct {
+	int samplingrate;
+	int motes;
+} samplingrate_demand;
+
+/**
+ * max-min fair share of energy for the mote and its direct childs (sampling rate level)
+ *
+ * sorted are the demands of the childs in ascending order of samplingrate, the drain
+ * of a child is weighted by the motes of its subtree. max_messages is the demand of the
+ * mote itself (-1 for no limit). FPINT_MAX if all demands are satisfied. Has no side effects.
+ */
+fpint samplingrate_waterfill(fpint fp_energy, fpint fp_drain_self, fpint fp_drain_child, int max_messages, const samplingrate_demand* sorted, int count);
+
+/**
+ * calculates the sampling rate for an interval by a max-min fair allocation
+ * of energy to the mote and its direct childs (SDF_SAMPLINGRATE_ALLOCATION)
+ *
+ * energy not needed for childs with a demand below the returned sampling rate is
+ * used for the mote and the other childs, the returned sampling rate is the limit
+ * for the childs as well. demand is set to the sampling rate achievable without
+ * max_messages (reported to the parent).
+ */
+int samplingrate_allocate(int max_messages, const samplingrate_demand* demands, int count, int* demand);
+
+/**
+ * energy budget of the mote for the next interval (reported to parent and childs)
+ */
+fpint samplingrate_energy();
+
+/**
+ * sampling rate of a subtree of motes whose samples an energy budget suffices
+ * to receive and forward (-1 while no energy drain of the radio is known)
+ */
+int samplingrate_forwardable(fpint fp_energy, int motes);
+
+/**
+ * number of childs whose samples are received and forwarded (all childs of subtree)
+ */
+int samplingrate_childs();
+
 /**
  * takes an sample of the energy drains needed for calculating sampling rate
+ *
+ * (called once every SDF_SAMPLINGRATE_UPDATEINTERVAL, also advances the
+ * integral of SDF_SAMPLINGRATE_CONTROLLER_BATTERY)
  */
 void samplingrate_sample_energy_drain(int last_samplingrate, int last_childcount);
 
@@ -1,10 +1,41 @@
+#include "contiki.h"
 #include "sdf-config.h"
+
 #include "solarpanel.h"
 #include "drandom.h"
 #include "gccbugs.h"
 #include "fpint.h"
 #include "time.h"
 
+#if SOLARPANEL_TABLE
+	#include "solarpanel-table.h"
+#endif
+
+/**
+ * reciprocals of constant divisors
+ */
+static const fpint_reciprocal reciprocal_speedmultiplier = FPINT_RECIPROCAL(SPEEDMULTIPLIER);
+static const fpint_reciprocal reciprocal_hour            = FPINT_RECIPROCAL(3600);
+static const fpint_reciprocal reciprocal_hundred         = FPINT_RECIPROCAL(100);
+#if !SOLARPANEL_TABLE
+	static const fpint_reciprocal reciprocal_volt        = FPINT_RECIPROCAL(SOLARPANEL_VOLT);
+#endif
+
+/**
+ * seconds between two harvest calculations
+ */
+#define HARVEST_INTERVAL 60
+
+/**
+ * subscribers of harvested energy
+ */
+static solarpanel_subscriber* subscribers = NULL;
+
+/**
+ * process for periodically calculating harvested energy
+ */
+PROCESS(solarpanel_process, "Solarpanel-Process");
+
 /**
  * whether initial noise has been calculated
  */
@@ -44,6 +75,60 @@ static void update_noise() {
 	}
 }
 
+/**
+ * adds random noise in percent to energy
+ */
+static fpint add_noise(fpint fp_energy, int noise) {
+	if(noise != 0) {
+		fpint fp_noise = fpint_mul(fpint_to(noise), fpint_div_reciprocal(fp_energy, &reciprocal_hundred));
+		fp_energy = fpint_add(fp_energy, fp_noise);
+	}
+
+	return fpint_max(0, fp_energy);
+}
+
+#if SOLARPANEL_TABLE
+
+/**
+ * reciprocals of table steps
+ */
+static const fpint_reciprocal reciprocal_table_days    = FPINT_RECIPROCAL(SOLARPANEL_TABLE_DAYS);
+static const fpint_reciprocal reciprocal_table_minutes = FPINT_RECIPROCAL(SOLARPANEL_TABLE_MINUTES);
+
+/**
+ * linear interpolation between two values
+ */
+static fpint interpolate(fpint a, fpint b, fpint fp_fraction) {
+	return a + fpint_mul(b - a, fp_fraction);
+}
+
+/**
+ * current of solarpanel in mA by bilinear interpolation of the generated table
+ */
+static fpint current_table(unsigned int day, unsigned int minute) {
+	// table only contains the left side of the symmetric day
+	if(minute > 720)
+		minute = 1440 - minute;
+
+	// table position
+	unsigned int row    = (unsigned int) fpint_udiv_reciprocal(day, &reciprocal_table_days);
+	unsigned int column = (unsigned int) fpint_udiv_reciprocal(minute, &reciprocal_table_minutes);
+	unsigned int next   = (column + 1 < SOLARPANEL_TABLE_COLUMNS) ? column + 1 : column;
+
+	// distance to table position
+	fpint fp_day_fraction    = fpint_div_reciprocal(fpint_to(day - row * SOLARPANEL_TABLE_DAYS), &reciprocal_table_days);
+	fpint fp_minute_fraction = fpint_div_reciprocal(fpint_to(minute - column * SOLARPANEL_TABLE_MINUTES), &reciprocal_table_minutes);
+
+	// interpolate minute in both days, then between days
+	// (there's always a next row: last row is the first day of next year)
+	fpint fp_row  = interpolate(solarpanel_table[row][column],     solarpanel_table[row][next],     fp_minute_fraction);
+	fpint fp_next = interpolate(solarpanel_table[row + 1][column], solarpanel_table[row + 1][next], fp_minute_fraction);
+
+	return interpolate(fp_row, fp_next, fp_day_fraction) << SOLARPANEL_TABLE_SHIFT;
+}
+
+#else
+
 /**
  * energy calculated by brock formula in Wh
  *
@@ -107,7 +192,7 @@ static fpint energy_brock(int day, int minute, fpint fp_lat) {
 		long fp_sr = fpint_mul(fpint_div(0x5490000, fpint_mul(fp_rv, fp_rv)), fp_cosza);
 	#endif
 
-	return fpint_div(fpint_max(0, fp_sr), fpint_to(SPEEDMULTIPLIER));
+	return fpint_div_reciprocal(fpint_max(0, fp_sr), &reciprocal_speedmultiplier);
 }
 
 /**
@@ -125,32 +210,70 @@ static fpint energy_corrected(fpint fp_energy, int noise) {
 	fpint fp_onehundredpercent = 0x640000;
 	fp_energy = fpint_div(fp_energy, fpint_div(fp_onehundredpercent, fpint_to(SOLARPANEL_EFFICIENCY)));
 
-	// random noise in energy
-	if(noise != 0) {
-		fpint fp_noise = fpint_mul(fpint_to(noise), fpint_div(fp_energy, fp_onehundredpercent));
-		fp_energy = fpint_add(fp_energy, fp_noise);
-	}
-
-	return fpint_max(0, fp_energy);
+	return add_noise(fp_energy, noise);
 }
 
+#endif
+
 fpint solarpanel_capacity(long seconds) {
 	#if SOLARPANEL_EMULATE
 		update_noise();
 
 		// calculate energy of solar panel
-		fpint fp_lat = 0xDEDC; // Darmstadt: 49.878667 * PI / 180 = 0.8705
-		fpint fp_energy = energy_brock(time_day(), time_minute(), fp_lat);
-			  fp_energy = energy_corrected(fp_energy, noise_lifetime + noise_day);
+		#if SOLARPANEL_TABLE
+			fpint fp_mah = fpint_div_reciprocal(current_table(time_day(), time_minute()), &reciprocal_speedmultiplier);
+				  fp_mah = add_noise(fp_mah, noise_lifetime + noise_day);
+		#else
+			fpint fp_lat = (fpint) (SOLARPANEL_LATITUDE * FPINT_PI / 180); // degrees to radians
+			fpint fp_energy = energy_brock(time_day(), time_minute(), fp_lat);
+				  fp_energy = energy_corrected(fp_energy, noise_lifetime + noise_day);
 
-		// convert Watthours to Milliamperhours
-		fpint fp_onethousand = 0x3E80000;
-		fpint fp_mah = fpint_mul(fpint_div(fp_energy, fpint_to(SOLARPANEL_VOLT)), fp_onethousand);
+			// convert Watthours to Milliamperhours
+			fpint fp_onethousand = 0x3E80000;
+			fpint fp_mah = fpint_mul(fpint_div_reciprocal(fp_energy, &reciprocal_volt), fp_onethousand);
+		#endif
 
-		// scaled mAh down to timeframe
-		fpint fp_hour = 0xE100000; // 1h in seconds
-		return fpint_mul(fpint_div(fp_mah, fp_hour), fpint_to(seconds));
+		// scaled mAh down to timeframe (1h in seconds)
+		return fpint_mul(fpint_div_reciprocal(fp_mah, &reciprocal_hour), fpint_to(seconds));
 	#else
 		#error no real solarpanel implemented
 	#endif
 }
+
+void solarpanel_subscribe(solarpanel_subscriber* subscriber) {
+	int first = (subscribers == NULL);
+
+	subscriber->next = subscribers;
+	subscribers = subscriber;
+
+	if(first)
+		process_start(&solarpanel_process, NULL);
+}
+
+/**
+ * calculates periodically the harvested energy and notifies all subscribers
+ */
+PROCESS_THREAD(solarpanel_process, ev, data) {
+	PROCESS_BEGIN();
+
+	// timer for updating solar calculation periodically
+	static struct etimer timer_update_solar;
+	etimer_set(&timer_update_solar, CLOCK_SECOND * HARVEST_INTERVAL / SPEEDMULTIPLIER);
+
+	// update loop
+	while(1) {
+		PROCESS_WAIT_UNTIL(etimer_expired(&timer_update_solar));
+
+		// calculate energy flow once for all subscribers
+		fpint fp_capacity = solarpanel_capacity(HARVEST_INTERVAL);
+
+		static solarpanel_subscriber* subscriber;
+		for(subscriber = subscribers; subscriber != NULL; subscriber = subscriber->next)
+			subscriber->harvested(fp_capacity);
+
+		// restart timer
+		etimer_reset(&timer_update_solar);
+	}
+
+	PROCESS_END();
+}
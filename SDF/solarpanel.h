@@ -1,11 +1,30 @@
 #ifndef __SOLARPANEL_H__
-#define __SOLARPANE_H__
+#define __SOLARPANEL_H__
 
 #include "fpint.h"
 
+/**
+ * subscriber of harvested solar energy
+ *
+ * static solarpanel_subscriber subscriber = { NULL, &harvested };
+ * solarpanel_subscribe(&subscriber);
+ */
+typedef struct solarpanel_subscriber {
+	struct solarpanel_subscriber* next;
+	void (*harvested)(fpint fp_capacity);
+} solarpanel_subscriber;
+
 /**
  * calculates mAh for solarpanel energy in Wh
  */
 fpint solarpanel_capacity(long seconds);
 
-#endif /* __SOLARPANE__ */
+/**
+ * subscribes to energy harvested by the solar panel
+ *
+ * the harvest process calculates the harvested mAh once every minute and calls
+ * every subscriber with the same value (process is started by first subscriber)
+ */
+void solarpanel_subscribe(solarpanel_subscriber* subscriber);
+
+#endif /* __SOLARPANEL_H__ */
@@ -4,6 +4,7 @@
 #include "net/rpl/rpl.h"
 #include "uip-debug.h"
 
+#include "sdf-config.h"
 #include "udphelper.h"
 
 #define DEBUG DEBUG_OFF
@@ -27,7 +28,32 @@ static int is_sink;
 /**
  * temporary ip for copy operations etc.
  */
-static uip_ipaddr_t temp_ip, temp_ip2;
+static uip_ipaddr_t temp_ip;
+
+/**
+ * normalized address of rpl parent
+ */
+static uip_ipaddr_t parent;
+
+/**
+ * whether mote has a rpl parent
+ */
+static int has_parent = 0;
+
+/**
+ * whether rpl parent is the sink
+ */
+static int parent_is_sink = 0;
+
+/**
+ * subscribers of parent changes
+ */
+static udphelper_parent_subscriber* subscribers = NULL;
+
+/**
+ * process for periodically checking rpl parent
+ */
+PROCESS(udphelper_parent_process, "UDPHelper-Parent-Process");
 
 /**
  * normalizes an ipv6 address by setting the first 16bits to aaaa
@@ -55,6 +81,10 @@ void udphelper_send(struct uip_udp_conn* udp, const uip_ipaddr_t* to, const void
 	uip_create_unspecified(&udp->ripaddr);
 }
 
+const uip_ipaddr_t* udphelper_packet_sender() {
+	return &UIP_IP_BUF->srcipaddr;
+}
+
 uip_ipaddr_t* udphelper_packet_senderaddress(uip_ipaddr_t* addr) {
 	uip_ipaddr_copy(addr, &UIP_IP_BUF->srcipaddr);
 	return normalize_address(addr);
@@ -77,6 +107,9 @@ void udphelper_registerlocaladdress(int sink) {
         uip_ip6addr(&temp_ip, 0xaaaa, 0, 0, 0, 0, 0, 0, 0);
         uip_ds6_set_addr_iid(&temp_ip, &uip_lladdr);
         uip_ds6_addr_add(&temp_ip, 0, ADDR_AUTOCONF);
+
+        // keep track of rpl parent
+        process_start(&udphelper_parent_process, NULL);
     } else {
     	// add udphelper_address_sink() to possible ip addresses
     	udphelper_address_sink(&temp_ip);
@@ -142,85 +175,191 @@ uip_ipaddr_t* udphelper_address_sink(uip_ipaddr_t* addr) {
     return addr;
 }
 
-uip_ipaddr_t* udphelper_address_parent(uip_ipaddr_t* addr) {
+uip_ipaddr_t* udphelper_address_childs(uip_ipaddr_t* addr) {
+	uip_create_linklocal_allnodes_mcast(addr);
+	return addr;
+}
+
+/**
+ * updates cached parent when rpl preferred parent has changed and notifies subscribers
+ */
+static void parent_update() {
+	int had_parent = has_parent;
+
     /*
      * code taken from examples/ipv6/rpl-collect/udp-sender.c
      */
-    rpl_dag_t *dag = rpl_get_any_dag();
-    if(dag->preferred_parent != NULL) {
-    	uip_ipaddr_copy(addr, &dag->preferred_parent->addr);
-    	return normalize_address(addr);
-    }
+	rpl_dag_t *dag = rpl_get_any_dag();
+	if(dag == NULL || dag->preferred_parent == NULL) {
+		has_parent = parent_is_sink = 0;
+	} else if(!has_parent || !udphelper_address_equals(&parent, &dag->preferred_parent->addr)) {
+		uip_ipaddr_copy(&parent, &dag->preferred_parent->addr);
+		normalize_address(&parent);
+		has_parent = 1;
+
+		udphelper_address_sink(&temp_ip);
+		parent_is_sink = udphelper_address_equals(&parent, &temp_ip);
+	} else {
+		return;
+	}
 
-    return NULL;
+	// notify parent change
+	if(has_parent || had_parent) {
+		udphelper_parent_subscriber* subscriber;
+		for(subscriber = subscribers; subscriber != NULL; subscriber = subscriber->next)
+			subscriber->changed(has_parent ? &parent : NULL);
+	}
 }
 
-int udphelper_address_equals(const uip_ipaddr_t* ip1, const uip_ipaddr_t* ip2) {
-	uip_ipaddr_copy(&temp_ip,  ip1);
-	uip_ipaddr_copy(&temp_ip2, ip2);
-	return uip_ipaddr_cmp(normalize_address(&temp_ip), normalize_address(&temp_ip2));
+const uip_ipaddr_t* udphelper_parent() {
+	return has_parent ? &parent : NULL;
 }
 
-int udphelper_childs_count() {
-    int count = 0, i;
-    for(i = 0; i < UIP_DS6_ROUTE_NB; i++) {
-        if(uip_ds6_routing_table[i].isused) {
-            count++;
-        }
-    }
+int udphelper_parent_is_sink() {
+	return parent_is_sink;
+}
 
-    return count;
+void udphelper_parent_subscribe(udphelper_parent_subscriber* subscriber) {
+	subscriber->next = subscribers;
+	subscribers = subscriber;
 }
 
-int udphelper_childs_all_count() {
-	int childs = 0, i;
-    for(i = 0; i < UIP_DS6_ROUTE_NB; i++)
-        if(uip_ds6_routing_table[i].isused)
-        	childs++;
+/**
+ * checks periodically for rpl parent changes
+ */
+PROCESS_THREAD(udphelper_parent_process, ev, data) {
+	PROCESS_BEGIN();
+
+	static struct etimer timer_parent;
+	etimer_set(&timer_parent, CLOCK_SECOND * UDPHELPER_PARENTINTERVAL);
 
-    return childs;
+	while(1) {
+		PROCESS_WAIT_UNTIL(etimer_expired(&timer_parent));
+		parent_update();
+		etimer_reset(&timer_parent);
+	}
+
+	PROCESS_END();
 }
 
+uip_ipaddr_t* udphelper_address_parent(uip_ipaddr_t* addr) {
+	if(udphelper_parent() == NULL)
+		return NULL;
 
-uip_ipaddr_t* udphelper_childs_all_get(int pos, uip_ipaddr_t* addr) {
-	int i, j = 0;
-	for(i = 0; i < UIP_DS6_ROUTE_NB; i++) {
-        if(uip_ds6_routing_table[i].isused) {
-        	if(pos == j) {
-        		uip_ipaddr_copy(addr, &uip_ds6_routing_table[i].ipaddr);
-        		return normalize_address(addr);
-        	}
+	uip_ipaddr_copy(addr, &parent);
+	return addr;
+}
 
-        	j++;
-        }
-	}
+int udphelper_address_equals(const uip_ipaddr_t* ip1, const uip_ipaddr_t* ip2) {
+	// normalized addresses only differ in first 16bits (fe80 link-local or aaaa global prefix)
+	if(ip1 == NULL || ip2 == NULL)
+		return 0;
 
-	return NULL;
+	return memcmp(&ip1->u8[2], &ip2->u8[2], sizeof(uip_ipaddr_t) - 2) == 0;
 }
 
-int udphelper_childs_direct_count() {
-	int childs = 0, i;
-    for(i = 0; i < UIP_DS6_ROUTE_NB; i++)
-        if(uip_ds6_routing_table[i].isused && udphelper_address_equals(&uip_ds6_routing_table[i].ipaddr, &uip_ds6_routing_table[i].nexthop))
-        	childs++;
+/**
+ * index of rpl childs in routing table
+ *
+ * (contiki has no notification on routing table changes, so the route functions
+ * are wrapped by the linker to invalidate the index, see Makefile. The address of
+ * every indexed route is kept to detect changes bypassing these functions)
+ */
+static struct {
+	int valid;
+	unsigned char all_count, direct_count;
+	unsigned char all[UIP_DS6_ROUTE_NB], direct[UIP_DS6_ROUTE_NB];
+	uint16_t node[UIP_DS6_ROUTE_NB];
+} childs;
+
+uip_ds6_route_t* __real_uip_ds6_route_add(uip_ipaddr_t* ipaddr, u8_t length, uip_ipaddr_t* next_hop, u8_t metric);
+void __real_uip_ds6_route_rm(uip_ds6_route_t* route);
+void __real_uip_ds6_route_rm_by_nexthop(uip_ipaddr_t* nexthop);
 
-    return childs;
+/**
+ * adds route and invalidates index of rpl childs (-Wl,--wrap=uip_ds6_route_add)
+ */
+uip_ds6_route_t* __wrap_uip_ds6_route_add(uip_ipaddr_t* ipaddr, u8_t length, uip_ipaddr_t* next_hop, u8_t metric) {
+	childs.valid = 0;
+	return __real_uip_ds6_route_add(ipaddr, length, next_hop, metric);
 }
 
-uip_ipaddr_t* udphelper_childs_direct_get(int pos, uip_ipaddr_t* addr) {
-	int i, j = 0;
+/**
+ * removes route and invalidates index of rpl childs (-Wl,--wrap=uip_ds6_route_rm)
+ */
+void __wrap_uip_ds6_route_rm(uip_ds6_route_t* route) {
+	childs.valid = 0;
+	__real_uip_ds6_route_rm(route);
+}
+
+/**
+ * removes routes via nexthop and invalidates index of rpl childs (-Wl,--wrap=uip_ds6_route_rm_by_nexthop)
+ *
+ * (calls uip_ds6_route_rm() within uip-ds6.c, which are not wrapped)
+ */
+void __wrap_uip_ds6_route_rm_by_nexthop(uip_ipaddr_t* nexthop) {
+	childs.valid = 0;
+	__real_uip_ds6_route_rm_by_nexthop(nexthop);
+}
+
+/**
+ * rebuilds index of rpl childs if routing table has changed
+ */
+static void childs_update() {
+	if(childs.valid)
+		return;
+
+	childs.all_count = childs.direct_count = 0;
+	int i;
 	for(i = 0; i < UIP_DS6_ROUTE_NB; i++) {
-        if(uip_ds6_routing_table[i].isused && udphelper_address_equals(&uip_ds6_routing_table[i].ipaddr, &uip_ds6_routing_table[i].nexthop)) {
-        	if(pos == j) {
-        		uip_ipaddr_copy(addr, &uip_ds6_routing_table[i].ipaddr);
-        		return normalize_address(addr);
-        	}
+		if(uip_ds6_routing_table[i].isused) {
+			childs.all[childs.all_count++] = i;
+			childs.node[i] = uip_ds6_routing_table[i].ipaddr.u16[7];
+			if(udphelper_address_equals(&uip_ds6_routing_table[i].ipaddr, &uip_ds6_routing_table[i].nexthop))
+				childs.direct[childs.direct_count++] = i;
+		}
+	}
 
-        	j++;
-        }
+	childs.valid = 1;
+}
+
+/**
+ * gets child at position pos of an index
+ *
+ * (a route changed since the index was built invalidates the index and is not returned)
+ */
+static uip_ipaddr_t* childs_get(const unsigned char* index, int count, int pos, int direct, uip_ipaddr_t* addr) {
+	if(pos < 0 || pos >= count)
+		return NULL;
+
+	uip_ds6_route_t* route = &uip_ds6_routing_table[index[pos]];
+	if(!route->isused || route->ipaddr.u16[7] != childs.node[index[pos]] || (direct && !udphelper_address_equals(&route->ipaddr, &route->nexthop))) {
+		childs.valid = 0;
+		return NULL;
 	}
 
-	return NULL;
+	uip_ipaddr_copy(addr, &route->ipaddr);
+	return normalize_address(addr);
+}
+
+int udphelper_childs_all_count() {
+	childs_update();
+	return childs.all_count;
+}
+
+uip_ipaddr_t* udphelper_childs_all_get(int pos, uip_ipaddr_t* addr) {
+	childs_update();
+	return childs_get(childs.all, childs.all_count, pos, 0, addr);
+}
+
+int udphelper_childs_direct_count() {
+	childs_update();
+	return childs.direct_count;
+}
+
+uip_ipaddr_t* udphelper_childs_direct_get(int pos, uip_ipaddr_t* addr) {
+	childs_update();
+	return childs_get(childs.direct, childs.direct_count, pos, 1, addr);
 }
 
 void udphelper_print_routing() {
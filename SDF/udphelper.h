@@ -4,6 +4,17 @@
 #include "contiki.h"
 #include "contiki-net.h"
 
+/**
+ * subscriber of rpl parent changes
+ *
+ * static udphelper_parent_subscriber subscriber = { NULL, &changed };
+ * udphelper_parent_subscribe(&subscriber);
+ */
+typedef struct udphelper_parent_subscriber {
+	struct udphelper_parent_subscriber* next;
+	void (*changed)(const uip_ipaddr_t* parent);
+} udphelper_parent_subscriber;
+
 /**
  * registers an udp socket to udp server
  */
@@ -19,6 +30,13 @@ void udphelper_send(struct uip_udp_conn* udp, const uip_ipaddr_t* to, const void
  */
 uip_ipaddr_t* udphelper_packet_senderaddress(uip_ipaddr_t* addr);
 
+/**
+ * get address of last received packet without copying it
+ *
+ * (address is not normalized, only valid until next packet is sent or received)
+ */
+const uip_ipaddr_t* udphelper_packet_sender();
+
 /**
  * get data of last received packet
  */
@@ -48,6 +66,13 @@ uip_ipaddr_t* udphelper_address_local(uip_ipaddr_t* addr);
  */
 uip_ipaddr_t* udphelper_address_sink(uip_ipaddr_t* addr);
 
+/**
+ * gets link-local all-nodes multicast address (reaching all direct rpl childs)
+ *
+ * returns pointer of parameters
+ */
+uip_ipaddr_t* udphelper_address_childs(uip_ipaddr_t* addr);
+
 /**
  * gets rpl ipv6 parent addr
  *
@@ -56,9 +81,31 @@ uip_ipaddr_t* udphelper_address_sink(uip_ipaddr_t* addr);
 uip_ipaddr_t* udphelper_address_parent(uip_ipaddr_t* addr);
 
 /**
- * comapres two ip addresses
+ * gets normalized rpl ipv6 parent addr without copying it
+ *
+ * (parent is cached and checked for changes every UDPHELPER_PARENTINTERVAL seconds
+ * after udphelper_registerlocaladdress() of a mote != sink)
+ *
+ * returns pointer to cached address or NULL without parent
+ */
+const uip_ipaddr_t* udphelper_parent();
+
+/**
+ * whether rpl parent is the sink (cached like udphelper_parent())
+ */
+int udphelper_parent_is_sink();
+
+/**
+ * subscribes to changes of rpl preferred parent
+ *
+ * subscribers are called with the new parent or NULL when the parent has been lost
+ */
+void udphelper_parent_subscribe(udphelper_parent_subscriber* subscriber);
+
+/**
+ * comapres two ip addresses (link-local and global addresses of a mote are equal)
  *
- * returns 1 for equality, 0 when not equals
+ * returns 1 for equality, 0 when not equals or an address is NULL
  */
 int udphelper_address_equals(const uip_ipaddr_t* ip1, const uip_ipaddr_t* ip2);
 
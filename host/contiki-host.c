@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <time.h>
+
+#include "contiki.h"
+#include "contiki-net.h"
+#include "contiki-lib.h"
+
+#include "udphelper.h"
+
+/**
+ *
+ *
+ * clock
+ *
+ *
+ */
+
+unsigned long long host_nanoseconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * nanoseconds since start of host program
+ */
+static unsigned long long host_uptime() {
+	static unsigned long long start = 0;
+	if(start == 0)
+		start = host_nanoseconds();
+
+	return host_nanoseconds() - start;
+}
+
+unsigned long clock_seconds() {
+	return (unsigned long) (host_uptime() / 1000000000ULL);
+}
+
+clock_time_t clock_time() {
+	return (clock_time_t) (host_uptime() * CLOCK_SECOND / 1000000000ULL);
+}
+
+/**
+ *
+ *
+ * energest
+ *
+ *
+ */
+
+energest_t energest_total_time[ENERGEST_TYPE_MAX];
+
+unsigned long energest_type_time(int type) {
+	return energest_total_time[type].current;
+}
+
+void energest_flush() {
+}
+
+/**
+ *
+ *
+ * timers (host has no scheduler: timers never expire)
+ *
+ *
+ */
+
+void etimer_set(struct etimer* et, clock_time_t interval) {
+	et->interval = interval;
+}
+
+void etimer_reset(struct etimer* et) {
+}
+
+void etimer_restart(struct etimer* et) {
+}
+
+void etimer_stop(struct etimer* et) {
+}
+
+int etimer_expired(struct etimer* et) {
+	return 0;
+}
+
+/**
+ *
+ *
+ * processes
+ *
+ *
+ */
+
+void process_start(struct process* p, const char* arg) {
+	p->thread(p, PROCESS_EVENT_INIT, (process_data_t) arg);
+}
+
+/**
+ *
+ *
+ * random (16 bit linear congruential generator)
+ *
+ *
+ */
+
+static unsigned short random_state;
+
+void random_init(unsigned short seed) {
+	random_state = seed;
+}
+
+unsigned short random_rand() {
+	random_state = random_state * 25173U + 13849U;
+	return random_state;
+}
+
+/**
+ *
+ *
+ * udphelper (host has no network, a single node without parent)
+ *
+ *
+ */
+
+int host_routes = 0;
+
+uip_ipaddr_t* udphelper_address_local(uip_ipaddr_t* addr) {
+	memset(addr, 0, sizeof(uip_ipaddr_t));
+	addr->u16[0] = 0xaaaa;
+	addr->u16[7] = 0x0200;
+	return addr;
+}
+
+int udphelper_childs_all_count() {
+	return host_routes;
+}
+
+int udphelper_childs_direct_count() {
+	return host_routes;
+}
+
+void udphelper_print_address(const uip_ipaddr_t* addr) {
+	int i;
+	for(i = 0; i < 8; i++)
+		printf((i == 0) ? "%x" : ":%x", addr->u16[i]);
+}
+
+/**
+ *
+ *
+ * main (runs all autostart processes once)
+ *
+ *
+ */
+
+int host_argc;
+char** host_argv;
+
+int main(int argc, char** argv) {
+	host_argc = argc;
+	host_argv = argv;
+
+	int i;
+	for(i = 0; autostart_processes[i] != NULL; i++)
+		process_start(autostart_processes[i], NULL);
+
+	return 0;
+}
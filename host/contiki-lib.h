@@ -0,0 +1,13 @@
+#ifndef __CONTIKI_LIB_HOST_H__
+#define __CONTIKI_LIB_HOST_H__
+
+/**
+ * random
+ */
+#define RANDOM_RAND_MAX 65535U
+
+void random_init(unsigned short seed);
+
+unsigned short random_rand();
+
+#endif /* __CONTIKI_LIB_HOST_H__ */
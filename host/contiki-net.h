@@ -0,0 +1,24 @@
+#ifndef __CONTIKI_NET_HOST_H__
+#define __CONTIKI_NET_HOST_H__
+
+#include "contiki.h"
+
+/**
+ * ipv6 address as used by uIP
+ */
+typedef union {
+	uint8_t  u8[16];
+	uint16_t u16[8];
+} uip_ipaddr_t;
+
+/**
+ * udp connection (opaque, there's no network on host)
+ */
+struct uip_udp_conn;
+
+/**
+ * number of routes of a host "node" (may be modified by host programs)
+ */
+extern int host_routes;
+
+#endif /* __CONTIKI_NET_HOST_H__ */
@@ -0,0 +1,117 @@
+#ifndef __CONTIKI_HOST_H__
+#define __CONTIKI_HOST_H__
+
+/**
+ * Minimal stub of the contiki apis used by the SDF library, so the library
+ * can be compiled and benchmarked on a linux host (make TARGET=host).
+ *
+ * There's no scheduler: process_start() runs a process thread once until
+ * its first wait and timers never expire. Everything else behaves like on
+ * a tmote sky (tick rates, energest counters).
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * clock
+ */
+typedef unsigned long clock_time_t;
+
+#define CLOCK_SECOND 128UL
+#define RTIMER_SECOND 32768UL
+
+/**
+ * seconds since start of host program
+ */
+unsigned long clock_seconds();
+
+/**
+ * clock ticks since start of host program
+ */
+clock_time_t clock_time();
+
+/**
+ * nanoseconds of a monotonic host clock (only available on host)
+ */
+unsigned long long host_nanoseconds();
+
+/**
+ * energest
+ */
+#define ENERGEST_TYPE_CPU      0
+#define ENERGEST_TYPE_LPM      1
+#define ENERGEST_TYPE_IRQ      2
+#define ENERGEST_TYPE_LED_GREEN  3
+#define ENERGEST_TYPE_LED_YELLOW 4
+#define ENERGEST_TYPE_LED_RED    5
+#define ENERGEST_TYPE_TRANSMIT 6
+#define ENERGEST_TYPE_LISTEN   7
+#define ENERGEST_TYPE_MAX      8
+
+typedef union {
+	unsigned long current;
+} energest_t;
+
+/**
+ * energest tick counters (may be modified by host programs to simulate drain)
+ */
+extern energest_t energest_total_time[ENERGEST_TYPE_MAX];
+
+unsigned long energest_type_time(int type);
+
+void energest_flush();
+
+/**
+ * timers
+ */
+struct etimer {
+	clock_time_t interval;
+};
+
+void etimer_set(struct etimer* et, clock_time_t interval);
+void etimer_reset(struct etimer* et);
+void etimer_restart(struct etimer* et);
+void etimer_stop(struct etimer* et);
+int etimer_expired(struct etimer* et);
+
+/**
+ * processes
+ */
+typedef unsigned char process_event_t;
+typedef void* process_data_t;
+
+#define PT_WAITING 0
+#define PT_ENDED   3
+
+#define PROCESS_EVENT_INIT 0x81
+
+struct process {
+	const char* name;
+	char (*thread)(struct process*, process_event_t, process_data_t);
+};
+
+#define PROCESS(name, strname) \
+	static char process_thread_##name(struct process*, process_event_t, process_data_t); \
+	struct process name = { strname, process_thread_##name }
+
+#define PROCESS_THREAD(name, ev, data) \
+	static char process_thread_##name(struct process* process_pt, process_event_t ev, process_data_t data)
+
+#define PROCESS_BEGIN() (void) process_pt; {
+#define PROCESS_END() } return PT_ENDED;
+#define PROCESS_WAIT_UNTIL(c) if(!(c)) return PT_WAITING
+
+#define AUTOSTART_PROCESSES(...) struct process* const autostart_processes[] = {__VA_ARGS__, NULL}
+
+extern struct process* const autostart_processes[];
+
+/**
+ * command line of host program (only available on host)
+ */
+extern int host_argc;
+extern char** host_argv;
+
+void process_start(struct process* p, const char* arg);
+
+#endif /* __CONTIKI_HOST_H__ */
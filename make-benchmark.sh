@@ -0,0 +1,7 @@
+make sdf-benchmark TARGET=sky
+
+msp430-size sdf-benchmark.sky
+
+java -mx512m -jar ../../contiki/tools/cooja/dist/cooja.jar -nogui=sdf-benchmark.csc
+
+cat COOJA.testlog
@@ -0,0 +1,533 @@
+#include <stdio.h>
+#include <string.h>
+#include "contiki.h"
+
+#include "sdf-config.h"
+#include "fpint.h"
+#include "energyledger.h"
+#include "energymeter.h"
+#include "battery.h"
+#include "circularbuffer.h"
+#include "consumptionrate.h"
+#include "samplingrate.h"
+#include "solarpanel.h"
+#include "co-sensor.h"
+#include "co2-sensor.h"
+#include "gps-sensor.h"
+#include "sample.h"
+#include "control.h"
+#include "gccbugs.h"
+
+#if !CONTIKI_TARGET_SKY
+	#include <math.h>
+#endif
+
+/**
+ * number of calls of every benchmarked function
+ */
+#if CONTIKI_TARGET_SKY
+	#define BENCHMARK_ITERATIONS 256UL
+#else
+	#define BENCHMARK_ITERATIONS 20000UL
+#endif
+
+/**
+ * number of random inputs of every accuracy check
+ */
+#if CONTIKI_TARGET_SKY
+	#define BENCHMARK_ACCURACY_INPUTS 4096UL
+#else
+	#define BENCHMARK_ACCURACY_INPUTS 4000000UL
+#endif
+
+/**
+ * number of prepared input values (has to be a power of two)
+ */
+#define BENCHMARK_INPUTS 64
+
+/**
+ * time measurement of benchmark
+ *
+ * host: nanoseconds of the complete loop
+ * sky:  MCLK cycles of every single call counted by Timer B (clocked by
+ *       SMCLK = MCLK = DCO) with interrupts disabled, so clock and radio
+ *       interrupts are not charged to the benchmarked function. Running the
+ *       firmware in MSPSim (sdf-benchmark.csc) gives exact cycle counts.
+ */
+#if CONTIKI_TARGET_SKY
+	#include "dev/watchdog.h"
+
+	/**
+	 * cycles needed for measuring an empty statement
+	 */
+	static unsigned long benchmark_overhead = 0;
+
+	/**
+	 * starts a measurement: clears the overflow flag of Timer B
+	 * (read again if the timer overflowed while clearing)
+	 */
+	static unsigned short benchmark_cycles_start() {
+		TBCTL &= ~TBIFG;
+		unsigned short tbr = TBR;
+		if(TBCTL & TBIFG) {
+			TBCTL &= ~TBIFG;
+			tbr = TBR;
+		}
+
+		return tbr;
+	}
+
+	/**
+	 * cycles elapsed since start of measurement
+	 *
+	 * interrupts are disabled, so an overflow of Timer B is only seen by TBIFG:
+	 * calls of up to 131071 cycles are measured correctly
+	 */
+	static unsigned long benchmark_cycles(unsigned short start) {
+		unsigned short tbr = TBR;
+		unsigned long overflow = 0;
+		if(TBCTL & TBIFG) {
+			// timer may have overflowed right after reading it
+			tbr = TBR;
+			overflow = 0x10000UL;
+		}
+
+		return overflow + tbr - start;
+	}
+
+	#define BENCHMARK_UNIT "cycles"
+	#define BENCHMARK_LOOP_START()
+	#define BENCHMARK_LOOP_STOP()
+	#define BENCHMARK_OP(statement) do { \
+			unsigned short tbr; \
+			unsigned long cycles; \
+			dint(); \
+			tbr = benchmark_cycles_start(); \
+			statement; \
+			cycles = benchmark_cycles(tbr); \
+			eint(); \
+			elapsed += (cycles > benchmark_overhead) ? cycles - benchmark_overhead : 0; \
+			watchdog_periodic(); \
+		} while(0)
+#else
+	#define BENCHMARK_UNIT "ns"
+	#define BENCHMARK_LOOP_START() unsigned long long start = host_nanoseconds()
+	#define BENCHMARK_LOOP_STOP() elapsed = host_nanoseconds() - start
+	#define BENCHMARK_OP(statement) statement
+#endif
+
+/**
+ * daily harvest samples
+ */
+CIRCULARBUFFER_STATS(harvest_samples, CONSUMPTIONRATE_SAMPLES);
+
+/**
+ * prepared input values (prevents the compiler from optimizing constant calls)
+ */
+static fpint fp_a[BENCHMARK_INPUTS], fp_b[BENCHMARK_INPUTS], fp_angle[BENCHMARK_INPUTS], fp_positive[BENCHMARK_INPUTS];
+static energymeter_sample samples_last[BENCHMARK_INPUTS], samples_now[BENCHMARK_INPUTS];
+
+/**
+ * constant divisors of the SDF libraries
+ */
+#define BENCHMARK_DIVISORS 4
+static const fpint_reciprocal benchmark_divisors[BENCHMARK_DIVISORS] = {
+	FPINT_RECIPROCAL(SPEEDMULTIPLIER),
+	FPINT_RECIPROCAL(SOLARPANEL_VOLT),
+	FPINT_RECIPROCAL(3600),
+	FPINT_RECIPROCAL(86400L / SDF_SAMPLINGRATE_UPDATEINTERVAL)
+};
+static const fpint_reciprocal benchmark_ticks_hour = FPINT_RECIPROCAL(ENERGYMETER_TICKS_PER_SECOND * 3600ULL);
+
+/**
+ * results of benchmarked functions are saved here so calls will not be removed
+ */
+static volatile fpint fp_result;
+
+/**
+ * simple deterministic pseudo random numbers for benchmark inputs
+ */
+static unsigned long benchmark_rand() {
+	static uint32_t state = DRANDOM_SEED;
+	state = state * 1103515245UL + 12345UL;
+	return state >> 8;
+}
+
+/**
+ * random fpint of complete 32 bit range scaled down by a random number of bits
+ * (every magnitude is checked equally often)
+ */
+static fpint benchmark_rand_fpint_full() {
+	uint32_t bits = ((uint32_t) benchmark_rand() << 16) ^ benchmark_rand();
+	return ((fpint) bits) >> (benchmark_rand() % 32);
+}
+
+/**
+ * random fpint within range [min, max)
+ */
+static fpint benchmark_rand_fpint(long min, long max) {
+	return fpint_to(min) + (fpint) (benchmark_rand() % (unsigned long) fpint_to(max - min));
+}
+
+/**
+ * random energymeter sample advancing a last sample by the ticks of (up to) an interval
+ * (random last samples also cover overflowing tickcounters)
+ */
+static void benchmark_rand_sample(energymeter_sample* last, energymeter_sample* now) {
+	uint32_t interval = ENERGYMETER_TICKS_PER_SECOND * SDF_SAMPLINGRATE_UPDATEINTERVAL;
+
+	last->cpu_active     = benchmark_rand();
+	last->cpu_sleep      = benchmark_rand();
+	last->radio_transmit = benchmark_rand();
+	last->radio_listen   = benchmark_rand();
+	last->sensor_co      = benchmark_rand();
+	last->sensor_co2     = benchmark_rand();
+	last->sensor_gps     = benchmark_rand();
+
+	now->cpu_active      = last->cpu_active     + benchmark_rand() % (interval / 20);
+	now->cpu_sleep       = last->cpu_sleep      + benchmark_rand() % interval;
+	now->radio_transmit  = last->radio_transmit + benchmark_rand() % (interval / 100);
+	now->radio_listen    = last->radio_listen   + benchmark_rand() % (interval / 10);
+	now->sensor_co       = last->sensor_co      + benchmark_rand() % (interval / 10);
+	now->sensor_co2      = last->sensor_co2     + benchmark_rand() % (interval / 100);
+	now->sensor_gps      = last->sensor_gps     + benchmark_rand() % (interval / 50);
+}
+
+#if SDF_SAMPLINGRATE_ALLOCATION
+
+/**
+ * energy drain of a sample of the mote and of a child for water-filling checks
+ */
+#define BENCHMARK_DRAIN_SELF  0x1000
+#define BENCHMARK_DRAIN_CHILD 0x0800
+
+/**
+ * demands of childs for water-filling checks (sorted ascending, subtrees of 1 to 4 motes)
+ */
+static samplingrate_demand benchmark_demands[SDF_SAMPLINGRATE_ALLOCATION_CHILDS];
+
+/**
+ * random water-filling input with known sampling rate level (reference for accuracy)
+ *
+ * scenario 0: mote limited below the level (satisfied), no child satisfied
+ * scenario 1: mote not limited, childs below the level satisfied
+ * scenario 2: energy for all demands (level FPINT_MAX)
+ *
+ * returns the energy needed for the level
+ */
+static fpint benchmark_rand_allocation(int scenario, int* max_messages, fpint* fp_level) {
+	int i, j;
+	samplingrate_demand demand;
+	for(i = 0; i < SDF_SAMPLINGRATE_ALLOCATION_CHILDS; i++) {
+		demand.samplingrate = (scenario == 0) ? 100 + benchmark_rand() % 400 : 1 + benchmark_rand() % 500;
+		demand.motes        = 1 + benchmark_rand() % 4;
+		for(j = i; j > 0 && benchmark_demands[j - 1].samplingrate > demand.samplingrate; j--)
+			benchmark_demands[j] = benchmark_demands[j - 1];
+		benchmark_demands[j] = demand;
+	}
+	*max_messages = (scenario == 0) ? 1 + benchmark_rand() % 20 : (scenario == 1) ? -1 : 1 + benchmark_rand() % 500;
+	*fp_level     = (scenario == 0) ? benchmark_rand_fpint(21, 99) : (scenario == 1) ? benchmark_rand_fpint(1, 500) : fpint_to(501);
+
+	// every participant gets its demand or the level (childs for all motes of their subtree)
+	fpint fp_self   = (*max_messages != -1) ? fpint_min(fpint_to(*max_messages), *fp_level) : *fp_level;
+	fpint fp_energy = fpint_mul(fp_self, BENCHMARK_DRAIN_SELF);
+	for(i = 0; i < SDF_SAMPLINGRATE_ALLOCATION_CHILDS; i++) {
+		fpint fp_child = fpint_min(fpint_to(benchmark_demands[i].samplingrate), *fp_level);
+		fp_energy = fpint_add(fp_energy, fpint_mul(fp_child, BENCHMARK_DRAIN_CHILD * benchmark_demands[i].motes));
+	}
+
+	// energy left over with all demands satisfied
+	if(scenario == 2) {
+		fp_energy = fpint_add(fp_energy, FPINT_ONE);
+		*fp_level = FPINT_MAX;
+	}
+
+	return fp_energy;
+}
+
+#endif
+
+/**
+ * prepares all input values
+ */
+static void benchmark_init() {
+	#if CONTIKI_TARGET_SKY
+		// Timer B: SMCLK, continuous mode
+		TBCTL = TBSSEL_2 | MC_2 | TBCLR;
+
+		// calibrate measurement overhead
+		unsigned long long elapsed = 0;
+		BENCHMARK_OP(;);
+		benchmark_overhead = (unsigned long) elapsed;
+	#endif
+
+	int i;
+	for(i = 0; i < BENCHMARK_INPUTS; i++) {
+		fp_a[i]        = benchmark_rand_fpint(-180, 180);
+		fp_b[i]        = benchmark_rand_fpint(1, 180);
+		fp_angle[i]    = benchmark_rand_fpint(-7, 7);
+		fp_positive[i] = benchmark_rand_fpint(0, 30000);
+		benchmark_rand_sample(&samples_last[i], &samples_now[i]);
+	}
+
+	// daily harvest samples for quantile and consumption rate
+	for(i = 0; i < CONSUMPTIONRATE_SAMPLES; i++) {
+		fpint fp_harvest = benchmark_rand_fpint(20, 120);
+		circularbuffer_stats_save(&harvest_samples, fp_harvest);
+		consumptionrate_forecast->update(fp_harvest, TIME_DAY + i);
+	}
+
+	// energy drain samples for sampling rate calculation: reference sample and
+	// full intervals with transmissions, receptions and sensing
+	static gps_position gps;
+	energyledger_update();
+	samplingrate_sample_energy_drain(0, 0);
+	for(i = 0; i < SDF_SAMPLINGRATE_ENERGYSAMPLES; i++) {
+		energest_total_time[ENERGEST_TYPE_TRANSMIT].current += ENERGYMETER_TICKS_PER_SECOND * 2;
+		energest_total_time[ENERGEST_TYPE_LISTEN].current   += ENERGYMETER_TICKS_PER_SECOND * 30;
+		co_value();
+		co2_value();
+		gps_value(&gps);
+		energyledger_update();
+		samplingrate_sample_energy_drain(10, 2);
+	}
+}
+
+/**
+ * 4th-order polynomial sine used by fpint_sin() before the table lookup (reference for accuracy)
+ *
+ * sin(x) ≈ 0,0375758*x^4 - 0,236096*x^3 + 0,0582877*x^2 + 0,0981968*x
+ */
+static fpint benchmark_sin_polynomial(fpint x) {
+	int factor = 1;
+	if(x < 0) {
+		x = fpint_abs(x);
+		factor *= -1;
+	}
+	if(x > FPINT_PI) {
+		if((x / FPINT_PI) % 2 == 1)
+			factor *= -1;
+		x %= FPINT_PI;
+	}
+
+	fpint fp_xit = x;
+	fpint fp_sum = fpint_mul(0xFB62, fp_xit);
+	fp_xit = fpint_mul(fp_xit, x);
+	fp_sum = fpint_add(fp_sum, fpint_mul(0x0EEC, fp_xit));
+	fp_xit = fpint_mul(fp_xit, x);
+	fp_sum = fpint_sub(fp_sum, fpint_mul(0x3C71, fp_xit));
+	fp_xit = fpint_mul(fp_xit, x);
+	fp_sum = fpint_add(fp_sum, fpint_mul(0x099F, fp_xit));
+
+	return fpint_mul(fp_sum, fpint_to(factor));
+}
+
+/**
+ * average of samples of a circularbuffer_stats by scanning all samples (reference for accuracy)
+ */
+static fpint benchmark_stats_avg(const circularbuffer_stats* stats) {
+	unsigned short pos, count = circularbuffer_count(&stats->buffer);
+	long long sum = 0;
+	for(pos = 0; pos < count; pos++)
+		sum += *(fpint*) circularbuffer_get(&stats->buffer, pos);
+
+	return (count > 0) ? (fpint) gccbugs_lldiv(sum, count) : 0;
+}
+
+/**
+ * prints result of a benchmarked function
+ */
+static void benchmark_report(const char* name, unsigned long ops, unsigned long long elapsed) {
+	printf("%-42s %8lu ops %10lu %s/op\n", name, ops, (unsigned long) (elapsed / ops), BENCHMARK_UNIT);
+}
+
+/**
+ * prints result of an accuracy check
+ */
+static void benchmark_report_accuracy(const char* name, unsigned long inputs, unsigned long mismatches, fpint fp_maxerror) {
+	printf("%-42s %8lu inputs %8lu mismatches (max error %s)\n", name, inputs, mismatches, fpint_str(fp_maxerror, fpint_strbuf));
+}
+
+/**
+ * compares function with reference function on BENCHMARK_ACCURACY_INPUTS
+ * inputs a and b created by statement
+ */
+#define BENCHMARK_ACCURACY(name, statement, function, reference) do { \
+		unsigned long i, mismatches = 0; \
+		fpint a, b, fp_error, fp_maxerror = 0; \
+		for(i = 0; i < BENCHMARK_ACCURACY_INPUTS; i++) { \
+			statement; \
+			fp_error = fpint_abs(fpint_sub(function, reference)); \
+			if(fp_error != 0) \
+				mismatches++; \
+			fp_maxerror = fpint_max(fp_maxerror, fp_error); \
+		} \
+		benchmark_report_accuracy(name, BENCHMARK_ACCURACY_INPUTS, mismatches, fp_maxerror); \
+	} while(0)
+
+/**
+ * runs statement BENCHMARK_ITERATIONS times with i as iteration
+ * and n as input index
+ */
+#define BENCHMARK(name, statement) do { \
+		unsigned long i, n; \
+		unsigned long long elapsed = 0; \
+		BENCHMARK_LOOP_START(); \
+		for(i = 0; i < BENCHMARK_ITERATIONS; i++) { \
+			n = i & (BENCHMARK_INPUTS - 1); (void) n; \
+			BENCHMARK_OP(statement); \
+		} \
+		BENCHMARK_LOOP_STOP(); \
+		benchmark_report(name, BENCHMARK_ITERATIONS, elapsed); \
+	} while(0)
+
+/**
+ * SDF-Benchmark process
+ */
+PROCESS(sdfbenchmark, "SDF-Benchmark");
+AUTOSTART_PROCESSES(&sdfbenchmark);
+PROCESS_THREAD(sdfbenchmark, ev, data) {
+	PROCESS_BEGIN();
+
+	printf("Started SDF-Benchmark (%lu iterations)\n", BENCHMARK_ITERATIONS);
+	benchmark_init();
+
+	// accuracy
+	BENCHMARK_ACCURACY("fpint_mul == gccbugs_llmul",
+		a = benchmark_rand_fpint_full(); b = benchmark_rand_fpint_full(),
+		fpint_mul(a, b), (fpint) (gccbugs_llmul(a, b) >> 16));
+	BENCHMARK_ACCURACY("fpint_div_reciprocal == fpint_div",
+		a = benchmark_rand_fpint_full(); b = benchmark_divisors[i % BENCHMARK_DIVISORS].divisor,
+		fpint_div_reciprocal(a, &benchmark_divisors[i % BENCHMARK_DIVISORS]), fpint_div(a, fpint_to(b)));
+	BENCHMARK_ACCURACY("fpint_udiv_reciprocal == gccbugs_ulldiv",
+		a = benchmark_rand_fpint_full(); b = 0; (void) b,
+		(fpint) fpint_udiv_reciprocal((uint32_t) a, &benchmark_ticks_hour), (fpint) gccbugs_ulldiv((uint32_t) a, benchmark_ticks_hour.divisor));
+	BENCHMARK_ACCURACY("fpint_sin == polynomial sine",
+		a = benchmark_rand_fpint(-20, 20); b = 0; (void) b,
+		fpint_sin(a), benchmark_sin_polynomial(a));
+	{
+		CIRCULARBUFFER_STATS(stats, CONSUMPTIONRATE_SAMPLES);
+		BENCHMARK_ACCURACY("circularbuffer_stats_quantile == fpint_quant.",
+			circularbuffer_stats_save(&stats, benchmark_rand_fpint(0, 40)); a = b = 0xFFFEB7EC,
+			circularbuffer_stats_quantile(&stats, a), fpint_quantile(stats_elements, circularbuffer_count(&stats.buffer), b));
+	}
+	{
+		CIRCULARBUFFER_STATS(stats, SDF_SAMPLINGRATE_ENERGYSAMPLES);
+		BENCHMARK_ACCURACY("circularbuffer_stats_drain == scanned avg",
+			circularbuffer_stats_save(&stats, benchmark_rand_fpint(-40, 40)); if(i % 3 == 0) circularbuffer_stats_drain(&stats, NULL); a = b = 0; (void) a; (void) b,
+			circularbuffer_stats_avg(&stats), benchmark_stats_avg(&stats));
+	}
+	BENCHMARK_ACCURACY("fpint_sqrt == fpint_sqrt_epsilon",
+		a = fpint_abs(benchmark_rand_fpint_full()); b = 0; (void) b,
+		fpint_sqrt(a), fpint_sqrt_epsilon(a, 0x0021));
+	#if !CONTIKI_TARGET_SKY
+		BENCHMARK_ACCURACY("fpint_sqrt == sqrt",
+			a = fpint_abs(benchmark_rand_fpint_full()); b = 0; (void) b,
+			fpint_sqrt(a), (fpint) lround(sqrt(a * 65536.0)));
+		BENCHMARK_ACCURACY("fpint_sqrt_epsilon == sqrt",
+			a = fpint_abs(benchmark_rand_fpint_full()); b = 0; (void) b,
+			fpint_sqrt_epsilon(a, 0x0021), (fpint) lround(sqrt(a * 65536.0)));
+		BENCHMARK_ACCURACY("fpint_sin == sin",
+			a = benchmark_rand_fpint(-20, 20); b = 0; (void) b,
+			fpint_sin(a), (fpint) lround(sin(a / 65536.0) * 65536.0));
+		BENCHMARK_ACCURACY("polynomial sine == sin",
+			a = benchmark_rand_fpint(-20, 20); b = 0; (void) b,
+			benchmark_sin_polynomial(a), (fpint) lround(sin(a / 65536.0) * 65536.0));
+	#endif
+
+	// fpint
+	BENCHMARK("fpint_mul",                                fp_result = fpint_mul(fp_a[n], fp_b[n]));
+	BENCHMARK("fpint_mul (gccbugs_llmul)",                fp_result = (fpint) (gccbugs_llmul(fp_a[n], fp_b[n]) >> 16));
+	BENCHMARK("fpint_div",                                fp_result = fpint_div(fp_a[n], fp_b[n]));
+	BENCHMARK("fpint_div (constant divisor)",             fp_result = fpint_div(fp_a[n], fpint_to(SOLARPANEL_VOLT)));
+	BENCHMARK("fpint_div_reciprocal",                     fp_result = fpint_div_reciprocal(fp_a[n], &benchmark_divisors[1]));
+	BENCHMARK("gccbugs_ulldiv",                           fp_result = (fpint) gccbugs_ulldiv((uint32_t) fp_positive[n], benchmark_ticks_hour.divisor));
+	BENCHMARK("fpint_udiv_reciprocal",                    fp_result = (fpint) fpint_udiv_reciprocal((uint32_t) fp_positive[n], &benchmark_ticks_hour));
+	BENCHMARK("fpint_multimes",                           fp_result = fpint_multimes(fp_b[n], 40000UL + n));
+	BENCHMARK("fpint_sin",                                fp_result = fpint_sin(fp_angle[n]));
+	BENCHMARK("fpint_sin (polynomial)",                   fp_result = benchmark_sin_polynomial(fp_angle[n]));
+	BENCHMARK("fpint_cos",                                fp_result = fpint_cos(fp_angle[n]));
+	BENCHMARK("fpint_sqrt",                               fp_result = fpint_sqrt(fp_positive[n]));
+	BENCHMARK("fpint_sqrt_epsilon",                       fp_result = fpint_sqrt_epsilon(fp_positive[n], 0x0021));
+	BENCHMARK("fpint_avg",                                fp_result = fpint_avg(harvest_samples.buffer.elements, CONSUMPTIONRATE_SAMPLES));
+	BENCHMARK("fpint_quantile",                           fp_result = fpint_quantile(harvest_samples.buffer.elements, CONSUMPTIONRATE_SAMPLES, 0xFFFEB7EC));
+	BENCHMARK("fpint_str",                                fp_result = fpint_str(fp_a[n], fpint_strbuf)[0]);
+
+	// circularbuffer
+	{
+		CIRCULARBUFFER(buffer, fpint, SDF_SAMPLINGRATE_ENERGYSAMPLES);
+		static fpint drained;
+		BENCHMARK("circularbuffer_save",                  circularbuffer_save(&buffer, &fp_a[n]));
+		BENCHMARK("circularbuffer_get",                   fp_result = *(fpint*) circularbuffer_get(&buffer, n % SDF_SAMPLINGRATE_ENERGYSAMPLES));
+		BENCHMARK("circularbuffer_save + drain",          circularbuffer_save(&buffer, &fp_a[n]); circularbuffer_drain(&buffer, &drained));
+
+		CIRCULARBUFFER_STATS(stats, SDF_SAMPLINGRATE_ENERGYSAMPLES);
+		BENCHMARK("circularbuffer_stats_save",            circularbuffer_stats_save(&stats, fp_a[n]));
+		BENCHMARK("circularbuffer_stats_save + drain",    circularbuffer_stats_save(&stats, fp_a[n]); circularbuffer_stats_drain(&stats, &drained));
+		BENCHMARK("circularbuffer_stats_avg",             fp_result = circularbuffer_stats_avg(&harvest_samples));
+		BENCHMARK("circularbuffer_stats_quantile",        fp_result = circularbuffer_stats_quantile(&harvest_samples, 0xFFFEB7EC));
+	}
+
+	// energymeter
+	{
+		static energymeter_sample last;
+		BENCHMARK("energymeter_calculate_drain",          fp_result = energymeter_calculate_drain(&samples_last[n], &samples_now[n], ENERGYMETER_DRAIN_WITH_INCOMPLETE_TIMEFRAMES));
+		BENCHMARK("energymeter_calculate_drain_update_last", memcpy(&last, &samples_last[n], sizeof(energymeter_sample)); fp_result = energymeter_calculate_drain_update_last(&last, &samples_now[n], ENERGYMETER_DRAIN_ONLY_FULL_TIMEFRAMES));
+		BENCHMARK("energymeter_sampling",                 energymeter_sampling(&last));
+	}
+
+	// energyledger
+	{
+		static energyledger_cursor cursor;
+		BENCHMARK("energyledger_update",                  energyledger_update());
+		BENCHMARK("energyledger_drain",                   fp_result = energyledger_drain(&cursor, ENERGYLEDGER_RADIO_TRANSMIT));
+		BENCHMARK("energyledger_drain (all sources)",     fp_result = energyledger_drain(&cursor, ENERGYLEDGER_ALL));
+		BENCHMARK("energyledger_cursor_advance",          energyledger_cursor_advance(&cursor));
+	}
+
+	// sample payload
+	{
+		static sample batch[SDF_SAMPLINGRATE_BATCH], decoded;
+		static uint8_t message[SAMPLE_MESSAGE_SIZE(SDF_SAMPLINGRATE_BATCH)];
+		BENCHMARK_ACCURACY("sample_decode == sample_encode",
+			batch[i % SDF_SAMPLINGRATE_BATCH].latitude = a = benchmark_rand_fpint_full(); batch[i % SDF_SAMPLINGRATE_BATCH].longitude = b = benchmark_rand_fpint_full(); batch[i % SDF_SAMPLINGRATE_BATCH].sequence = i;
+				sample_encode(batch, SDF_SAMPLINGRATE_BATCH, message); sample_decode(&decoded, message, i % SDF_SAMPLINGRATE_BATCH),
+			decoded.latitude ^ decoded.longitude ^ decoded.sequence, a ^ b ^ (uint16_t) i);
+		BENCHMARK("sample_encode (batch)",                batch[0].co = n; fp_result = sample_encode(batch, SDF_SAMPLINGRATE_BATCH, message));
+		BENCHMARK("sample_count",                         fp_result = sample_count(message, SAMPLE_MESSAGE_SIZE(SDF_SAMPLINGRATE_BATCH)));
+		BENCHMARK("sample_decode",                        sample_decode(&decoded, message, n % SDF_SAMPLINGRATE_BATCH); fp_result = decoded.co);
+	}
+
+	// control messages
+	{
+		static control_message control = { CONTROL_SAMPLINGRATE }, decoded;
+		static uint8_t message[CONTROL_SIZE];
+		BENCHMARK("control_encode",                       control.epoch = n; control.samplingrate = 1 + n % CONTROL_SAMPLINGRATE_MAX; fp_result = control_encode(&control, message));
+		BENCHMARK("control_decode",                       fp_result = control_decode(&decoded, message, CONTROL_SIZE));
+		BENCHMARK("control_epoch_newer",                  fp_result = control_epoch_newer(n, decoded.epoch));
+	}
+
+	// battery, solarpanel, consumptionrate and samplingrate
+	battery_init();
+	BENCHMARK("battery_capacity",                         fp_result = battery_capacity());
+	BENCHMARK("solarpanel_capacity",                      fp_result = solarpanel_capacity(60));
+	BENCHMARK("consumptionrate_forecast->forecast",       fp_result = consumptionrate_forecast->forecast(TIME_DAY + CONSUMPTIONRATE_SAMPLES));
+	BENCHMARK("consumptionrate_energy",                   fp_result = consumptionrate_energy(SDF_SAMPLINGRATE_UPDATEINTERVAL));
+	BENCHMARK("samplingrate_calculate",                   fp_result = samplingrate_calculate(-1));
+	#if SDF_SAMPLINGRATE_ALLOCATION
+	{
+		static const samplingrate_demand demands[SDF_SAMPLINGRATE_ALLOCATION_CHILDS] = { { 40, 1 }, { 5, 3 }, { 500, 1 }, { 12, 2 }, { 90, 1 }, { 7, 4 }, { 300, 1 }, { 25, 2 } };
+		static int demand, max_messages;
+		static fpint fp_level;
+		BENCHMARK_ACCURACY("samplingrate_waterfill == known level",
+			a = benchmark_rand_allocation(i % 3, &max_messages, &fp_level); b = fp_level,
+			samplingrate_waterfill(a, BENCHMARK_DRAIN_SELF, BENCHMARK_DRAIN_CHILD, max_messages, benchmark_demands, SDF_SAMPLINGRATE_ALLOCATION_CHILDS), b);
+		BENCHMARK("samplingrate_waterfill",               fp_result = samplingrate_waterfill(fp_b[n], BENCHMARK_DRAIN_SELF, BENCHMARK_DRAIN_CHILD, n % 20, benchmark_demands, SDF_SAMPLINGRATE_ALLOCATION_CHILDS));
+		BENCHMARK("samplingrate_allocate",                fp_result = samplingrate_allocate(-1, demands, 1 + n % SDF_SAMPLINGRATE_ALLOCATION_CHILDS, &demand));
+	}
+	#endif
+
+	printf("Finished SDF-Benchmark\n");
+
+	PROCESS_END();
+}
@@ -6,11 +6,14 @@
 
 #include "sdf-config.h"
 #include "battery.h"
+#include "energyledger.h"
 #include "energymeter.h"
 #include "consumptionrate.h"
 #include "co-sensor.h"
 #include "co2-sensor.h"
 #include "gps-sensor.h"
+#include "sample.h"
+#include "control.h"
 #include "udphelper.h"
 #include "time.h"
 #include "samplingrate.h"
@@ -19,11 +22,19 @@
 // (will only use 3/4 of buffer to make space for csma/routing messages)
 #define SENDQUEUE ((QUEUEBUF_NUM * 3) / 4)
 
+// interval for transmitting samplingrate to childs after its calculation
+#define SAMPLINGRATE_TRANSMITDELAY (CLOCK_SECOND * 2 / SPEEDMULTIPLIER)
+
+// grace period before requesting a missed samplingrate from parent
+// (parent's samplingrate is sent one transmit delay and backoff after its interval,
+// one more transmit delay is given for clock drift and forwarding)
+#define SAMPLINGRATE_REQUESTDELAY (2 * SAMPLINGRATE_TRANSMITDELAY + CLOCK_SECOND / 8)
+
 // udp socket
 static struct uip_udp_conn* udp;
 
 // static instance of SDF sink ip and parent ip
-static uip_ipaddr_t ip_sink, ip_parent;
+static uip_ipaddr_t ip_sink;
 
 // starting time of SDF algorithm
 static unsigned long time_init;
@@ -31,6 +42,9 @@ static unsigned long time_init;
 // initial samplingrate
 static int samplingrate;
 
+// samplingrate limit sent to childs
+static int samplingrate_limit_childs;
+
 // number of children the samplingrate has yet been tranmitted to
 static int samplingrate_children_transmitted = 0, samplingrate_children_count = 0;
 
@@ -52,65 +66,309 @@ static void update_sampling_rate(struct etimer* sampletimer, struct etimer* time
 // backoff timers for sending UDP messages
 static struct ctimer backofftimer_send_sample, backofftimer_send_samplingrate;
 
+#if SDF_SAMPLINGRATE_MULTICAST
+	// backoff timers for repairing missed multicast samplingrates
+	static struct ctimer backofftimer_request_samplingrate, backofftimer_repair_samplingrate;
+
+	// child having requested the samplingrate (a later request replaces a pending one,
+	// the child will request again in its next interval)
+	static uip_ipaddr_t ip_repair;
+
+	// parent epoch when the request was scheduled (request is dropped if it advanced meanwhile)
+	static uint16_t request_epoch;
+	static int request_epoch_valid;
+#endif
+
+// epoch of own samplingrate sent to childs
+static uint16_t samplingrate_epoch = 0;
+
+// epoch of last samplingrate received from parent (any epoch is accepted from a new parent)
+static uint16_t last_parent_epoch;
+static int last_parent_epoch_valid = 0;
+
+// energy budget reported with last samplingrate of parent
+static fpint last_parent_energy;
+
 /**
- * simple function for string to int conversion
- *
- * atoi() needed two much firmware size ;)
+ * encodes control message with own samplingrate for childs
+ */
+static int samplingrate_message(uint8_t* message) {
+	static control_message control;
+	control.type         = CONTROL_SAMPLINGRATE;
+	control.epoch        = samplingrate_epoch;
+	control.samplingrate = (samplingrate_limit_childs < CONTROL_SAMPLINGRATE_MAX) ? samplingrate_limit_childs : CONTROL_SAMPLINGRATE_MAX;
+	control.motes        = 1 + samplingrate_childs();
+	control.fp_energy    = samplingrate_energy();
+
+	return control_encode(&control, message);
+}
+
+#if SDF_SAMPLINGRATE_ALLOCATION
+
+/**
+ * samplingrates achievable by direct childs and motes of their subtrees
+ */
+static struct {
+	uint16_t node;
+	samplingrate_demand demand;
+	unsigned long time;
+} demands[SDF_SAMPLINGRATE_ALLOCATION_CHILDS];
+
+// own achievable samplingrate reported to parent
+static int demand;
+
+// backoff timer for reporting demand to parent
+static struct ctimer backofftimer_send_demand;
+
+/**
+ * saves demand of a child (replacing its last demand or the oldest demand)
  */
-static int str2int(char* str) {
-	int sum = 0, i = 0;
-	while(str[i] != '\0') {
-		sum = sum * 10 + (str[i] - '0');
-		i++;
+static void demand_save(uint16_t node, const control_message* control) {
+	int i, slot = 0;
+	for(i = 0; i < SDF_SAMPLINGRATE_ALLOCATION_CHILDS; i++) {
+		if(demands[i].node == node) {
+			slot = i;
+			break;
+		}
+		if(demands[i].time < demands[slot].time)
+			slot = i;
 	}
 
-	return sum;
+	demands[slot].node                = node;
+	demands[slot].demand.samplingrate = control->samplingrate;
+	demands[slot].demand.motes        = control->motes;
+	demands[slot].time                = time();
+}
+
+/**
+ * copies demands of childs reported within the last two intervals
+ *
+ * returns number of demands
+ */
+static int demands_current(samplingrate_demand* current) {
+	int i, count = 0;
+	for(i = 0; i < SDF_SAMPLINGRATE_ALLOCATION_CHILDS; i++)
+		if(demands[i].time != 0 && time() - demands[i].time <= 2 * SDF_SAMPLINGRATE_UPDATEINTERVAL)
+			current[count++] = demands[i].demand;
+
+	return count;
+}
+
+/**
+ * reports own achievable samplingrate to parent
+ */
+static void send_demand(void* ptr) {
+	static control_message control = { CONTROL_DEMAND };
+	static uint8_t message[CONTROL_SIZE];
+	control.epoch        = samplingrate_epoch;
+	control.samplingrate = (demand < CONTROL_SAMPLINGRATE_MAX) ? demand : CONTROL_SAMPLINGRATE_MAX;
+	control.motes        = 1 + samplingrate_childs();
+	control.fp_energy    = samplingrate_energy();
+
+	static uip_ipaddr_t ip;
+	if(udphelper_address_parent(&ip) != NULL)
+		udphelper_send(udp, &ip, message, control_encode(&control, message));
+}
+
+#endif
+
+/**
+ * samples buffered for next messages (own samples and with SDF_AGGREGATION samples of childs)
+ */
+#if SDF_AGGREGATION
+	#define SAMPLES_BUFFERED (SDF_SAMPLINGRATE_BATCH + SDF_AGGREGATION_SAMPLES)
+#else
+	#define SAMPLES_BUFFERED SDF_SAMPLINGRATE_BATCH
+#endif
+static sample samples[SAMPLES_BUFFERED];
+
+// a message of SDF_SAMPLINGRATE_BATCH samples has to fit into uip_buf
+#if UIP_LLH_LEN + UIP_IPUDPH_LEN + SAMPLE_MESSAGE_SIZE(SDF_SAMPLINGRATE_BATCH) > UIP_BUFSIZE
+	#error SDF_SAMPLINGRATE_BATCH samples exceed uip buffer (UIP_CONF_BUFFER_SIZE)
+#endif
+
+// a message of a child has to fit into the buffer besides an incomplete batch
+#if SDF_AGGREGATION && SDF_AGGREGATION_SAMPLES < SDF_SAMPLINGRATE_BATCH
+	#error SDF_AGGREGATION_SAMPLES has to be at least SDF_SAMPLINGRATE_BATCH
+#endif
+
+// number of buffered samples
+static int samples_buffered = 0;
+
+// last 16bits of local ipv6 address identifying samples of this mote
+static uint16_t node;
+
+/**
+ * sends buffered samples in messages of SDF_SAMPLINGRATE_BATCH samples
+ * (to the parent for aggregation, or to the sink)
+ *
+ * remaining samples of an incomplete batch are only sent with flush
+ */
+static void send_samples(int flush) {
+	static uint8_t message[SAMPLE_MESSAGE_SIZE(SDF_SAMPLINGRATE_BATCH)];
+	const uip_ipaddr_t* ip = &ip_sink;
+	#if SDF_AGGREGATION
+		static uip_ipaddr_t ip_next;
+		if(udphelper_address_parent(&ip_next) != NULL)
+			ip = &ip_next;
+	#endif
+
+	while(samples_buffered >= SDF_SAMPLINGRATE_BATCH || (flush && samples_buffered > 0)) {
+		int count = (samples_buffered < SDF_SAMPLINGRATE_BATCH) ? samples_buffered : SDF_SAMPLINGRATE_BATCH;
+		udphelper_send(udp, ip, message, sample_encode(samples, count, message));
+
+		samples_buffered -= count;
+		memmove(samples, samples + count, samples_buffered * sizeof(sample));
+	}
 }
 
 /**
  * samples sensors and sends packet
  */
 static void send_packet(void* ptr) {
-	// get sensor data
+	if(samples_buffered == SAMPLES_BUFFERED)
+		send_samples(0);
+
+	// get sensor data into batch
 	static gps_position gps;
-	co2_value();
-	co_value();
+	static uint16_t sequence = 0;
+	sample* s = &samples[samples_buffered++];
+	s->node = node;
+	s->co2  = co2_value();
+	s->co   = co_value();
 	gps_value(&gps);
-	
-	// send dummy sample (there's actually no firmware space for building real message)
-	udphelper_send(udp, &ip_sink, "dummy-sample-with-26-chars", strlen("dummy-sample-with-26-chars") + 1);
+	s->latitude  = gps.latitude;
+	s->longitude = gps.longitude;
+	s->battery   = battery_level();
+	s->sequence  = ++sequence;
+
+	// send full batches, and all samples with last sample of interval
+	send_samples(sampled >= samplingrate);
 
 	// take another sample
 	if(sampled < samplingrate)
 		etimer_reset((struct etimer*) ptr);
 }
 
+#if SDF_AGGREGATION
+
+// backoff timer for sending batches completed by samples of childs
+static struct ctimer backofftimer_send_aggregated;
+
+/**
+ * sends batches completed by samples of childs
+ */
+static void send_aggregated(void* ptr) {
+	send_samples(0);
+}
+
+/**
+ * merges samples received from a child into the buffered samples
+ *
+ * the buffer always has room for a message of a child (SDF_SAMPLINGRATE_BATCH
+ * samples), only samples of larger messages are dropped
+ */
+static void aggregate_samples() {
+	int i, count = sample_count(udphelper_packet_data(), udphelper_packet_datalen());
+	for(i = 0; i < count && samples_buffered < SAMPLES_BUFFERED; i++)
+		sample_decode(&samples[samples_buffered++], udphelper_packet_data(), i);
+
+	// completed batches are sent by backoff timer (see sending of samples in the process block),
+	// but without room for the next message of a child they are sent right away: the message
+	// has been decoded, so uip_buf can be used for sending
+	if(samples_buffered > SAMPLES_BUFFERED - SDF_SAMPLINGRATE_BATCH)
+		send_samples(0);
+	else if(samples_buffered >= SDF_SAMPLINGRATE_BATCH)
+		ctimer_set(&backofftimer_send_aggregated, CLOCK_SECOND / 8, send_aggregated, NULL);
+}
+
+#endif
+
 /**
  * sends samplingrate information to childs
  */
 static void send_samplingrate(void* ptr) {
 	// save samplingrate message
-	static char message[4];
-	sprintf(message, "%d", samplingrate);
+	static uint8_t message[CONTROL_SIZE];
+	int length = samplingrate_message(message);
 
 	// send message to childs
-	int sent = 0;
 	static uip_ipaddr_t ip;
-	while(++sent <= SENDQUEUE && samplingrate_children_transmitted < samplingrate_children_count) {
-		if(udphelper_childs_direct_get(samplingrate_children_transmitted++, &ip) != NULL)
-			udphelper_send(udp, &ip, message, strlen(message) + 1);
-	}
+	#if SDF_SAMPLINGRATE_MULTICAST
+		udphelper_send(udp, udphelper_address_childs(&ip), message, length);
+		samplingrate_children_transmitted = samplingrate_children_count;
+	#else
+		int sent = 0;
+		while(++sent <= SENDQUEUE && samplingrate_children_transmitted < samplingrate_children_count) {
+			if(udphelper_childs_direct_get(samplingrate_children_transmitted++, &ip) != NULL)
+				udphelper_send(udp, &ip, message, length);
+		}
+	#endif
 
 	// restart timer for remaining childs
 	if(samplingrate_children_transmitted < samplingrate_children_count)
 		etimer_reset((struct etimer*) ptr);
 }
 
+#if SDF_SAMPLINGRATE_MULTICAST
+
+/**
+ * requests samplingrate from parent (multicast samplingrate has been missed)
+ */
+static void request_samplingrate(void* ptr) {
+	static control_message control = { CONTROL_REQUEST };
+	static uint8_t message[CONTROL_SIZE];
+	static uip_ipaddr_t ip;
+
+	// samplingrate has arrived late
+	if(last_parent_epoch_valid != request_epoch_valid || (last_parent_epoch_valid && last_parent_epoch != request_epoch))
+		return;
+
+	if(udphelper_address_parent(&ip) != NULL)
+		udphelper_send(udp, &ip, message, control_encode(&control, message));
+}
+
+/**
+ * schedules a samplingrate request to parent unless its samplingrate arrives before
+ */
+static void schedule_request_samplingrate(clock_time_t delay) {
+	request_epoch = last_parent_epoch;
+	request_epoch_valid = last_parent_epoch_valid;
+	ctimer_set(&backofftimer_request_samplingrate, delay, request_samplingrate, NULL);
+}
+
+/**
+ * sends samplingrate to a single child having requested it
+ */
+static void repair_samplingrate(void* ptr) {
+	static uint8_t message[CONTROL_SIZE];
+	udphelper_send(udp, &ip_repair, message, samplingrate_message(message));
+}
+
+#endif
+
 /**
  * SDF-Client process
  */
 PROCESS(sdfclient, "SDF-Client");
 AUTOSTART_PROCESSES(&sdfclient);
+
+// whether rpl parent has changed since last handling
+static int parent_changed = 0;
+
+/**
+ * rpl parent has changed: samplingrate of old parent is invalid
+ */
+static void parent_change(const uip_ipaddr_t* parent) {
+	parent_changed = 1;
+	process_poll(&sdfclient);
+}
+
+/**
+ * subscription to rpl parent changes
+ */
+static udphelper_parent_subscriber parent_subscriber = { NULL, &parent_change };
+
 PROCESS_THREAD(sdfclient, ev, data) {
     PROCESS_BEGIN();
 
@@ -132,8 +390,10 @@ PROCESS_THREAD(sdfclient, ev, data) {
     uip_ipaddr_t ip;
     udphelper_print_address(udphelper_address_local(&ip));
     printf(")\n");
+    node = ip.u16[7];
 
     // init (after rpl dag creation!)
+    energyledger_init();
     battery_init();
     consumptionrate_init();
 
@@ -153,7 +413,7 @@ PROCESS_THREAD(sdfclient, ev, data) {
 
     // timer for transmitting sampling rate to children
     static struct etimer timer_samplingrate_transmit;
-    etimer_set(&timer_samplingrate_transmit, CLOCK_SECOND * 2 / SPEEDMULTIPLIER);
+    etimer_set(&timer_samplingrate_transmit, SAMPLINGRATE_TRANSMITDELAY);
     etimer_stop(&timer_samplingrate_transmit); // started by update_sampling_rate()
 
     // timer for taking samples and transmitting them
@@ -163,6 +423,9 @@ PROCESS_THREAD(sdfclient, ev, data) {
     // init node with first calculation of sampling rate
     update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 1);
 
+    // react on parent changes
+    udphelper_parent_subscribe(&parent_subscriber);
+
     while(1) {
     	PROCESS_WAIT_EVENT();
 
@@ -175,14 +438,36 @@ PROCESS_THREAD(sdfclient, ev, data) {
     		etimer_restart(&timer_consumptionrate);
     	}
 
+    	// new rpl parent: forget samplingrate of old parent and calculate a new one immediately
+    	// (capped by minimal samplingrate until new parent sends its samplingrate)
+    	if(parent_changed) {
+    		parent_changed = 0;
+    		last_parent_samlingrate = SDF_SAMPLINGRATE_MINIMAL;
+    		last_parent_epoch_valid = 0;
+    		update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 1);
+    		etimer_restart(&timer_updatesamplingrate);
+
+			#if SDF_SAMPLINGRATE_MULTICAST
+    			if(!udphelper_parent_is_sink())
+    				schedule_request_samplingrate(CLOCK_SECOND / 8);
+			#endif
+    	}
+
     	// update SDF sampling rate
     	if(etimer_expired(&timer_updatesamplingrate)) {
 			// no real calculation when not in init phase and parent is not sink
 			// (mote will keep last samplingrate as long as a new samplingrate is received)
-			if((time() - time_init) / SDF_INITIALIZATIONPHASE == 0 || udphelper_address_equals(udphelper_address_parent(&ip_parent), &ip_sink)) {
+			if((time() - time_init) / SDF_INITIALIZATIONPHASE == 0 || udphelper_parent_is_sink()) {
     			update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 1);
     		} else {
 				update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 0);
+
+				// no samplingrate has been received from parent in last interval
+				// (parent's samplingrate may still be in flight, so it is only requested
+				// if it does not arrive within a grace period)
+				#if SDF_SAMPLINGRATE_MULTICAST
+					schedule_request_samplingrate(SAMPLINGRATE_REQUESTDELAY);
+				#endif
 			}
 
     		etimer_restart(&timer_updatesamplingrate);
@@ -193,12 +478,35 @@ PROCESS_THREAD(sdfclient, ev, data) {
 			// for some reason the real tmote skys in TUDμNet have routing problems not existent in cooja simulator
 			// solution: test if sampling rate update was sent by known parent
 			// (prevents multiple recalculations on incorrect routing tables)
-			static uip_ipaddr_t ip_sender;
-			if(udphelper_address_equals(udphelper_address_parent(&ip_parent), udphelper_packet_senderaddress(&ip_sender))) {
-				last_parent_samlingrate = str2int(udphelper_packet_data());
-				update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 1);
-				etimer_restart(&timer_updatesamplingrate); // new interval for samplingrate is set by rpl parent
+			static control_message control;
+			int control_valid = control_decode(&control, udphelper_packet_data(), udphelper_packet_datalen());
+			if(control_valid && control.type == CONTROL_SAMPLINGRATE) {
+				// stale or duplicated samplingrates are ignored
+				if(udphelper_address_equals(udphelper_parent(), udphelper_packet_sender()) && (!last_parent_epoch_valid || control_epoch_newer(control.epoch, last_parent_epoch))) {
+					last_parent_epoch = control.epoch;
+					last_parent_epoch_valid = 1;
+					last_parent_samlingrate = control.samplingrate;
+					last_parent_energy = control.fp_energy;
+					update_sampling_rate(&timer_samples, &timer_samplingrate_transmit, 1);
+					etimer_restart(&timer_updatesamplingrate); // new interval for samplingrate is set by rpl parent
+				}
 			}
+			#if SDF_SAMPLINGRATE_ALLOCATION
+				else if(control_valid && control.type == CONTROL_DEMAND) {
+					demand_save(udphelper_packet_sender()->u16[7], &control);
+				}
+			#endif
+			#if SDF_SAMPLINGRATE_MULTICAST
+				else if(control_valid && control.type == CONTROL_REQUEST) {
+					udphelper_packet_senderaddress(&ip_repair);
+					ctimer_set(&backofftimer_repair_samplingrate, CLOCK_SECOND / 8, repair_samplingrate, NULL);
+				}
+			#endif
+			#if SDF_AGGREGATION
+				else if(!control_valid) {
+					aggregate_samples();
+				}
+			#endif
     	}
 
     	// transmit SDF sampling rate to childs
@@ -239,7 +547,7 @@ static void update_sampling_rate(struct etimer* sample_timer, struct etimer* tra
 		samplingrate_sample_energy_drain(samplingrate, last_samplingrate_childs);
 
 		// set infos for next sample
-		last_samplingrate_childs = udphelper_childs_all_count();
+		last_samplingrate_childs = samplingrate_childs();
 		last_samplingrate_energysample = time();
 	}
 
@@ -249,9 +557,40 @@ static void update_sampling_rate(struct etimer* sample_timer, struct etimer* tra
 		if((time() - time_init) / SDF_INITIALIZATIONPHASE == 0) {
 			fpint fp_samplingrate = fpint_div(fpint_to(SDF_SAMPLINGRATE_MINIMAL), fpint_to(SPEEDMULTIPLIER));
 			samplingrate = fpint_from(fpint_round(fp_samplingrate));
+			samplingrate_limit_childs = samplingrate;
 		} else {
-			int max_samples = (udphelper_address_equals(udphelper_address_parent(&ip_parent), &ip_sink)) ? -1 : last_parent_samlingrate;
-			samplingrate = samplingrate_calculate(max_samples);
+			int max_samples = (udphelper_parent_is_sink()) ? -1 : last_parent_samlingrate;
+
+			// samples of the subtree are limited to what the budget of the parent can forward
+			// (a parent with little budget is trusted even if its limit would allow more)
+			int forwardable = (max_samples != -1 && last_parent_epoch_valid) ? samplingrate_forwardable(last_parent_energy, 1 + samplingrate_childs()) : -1;
+			if(forwardable != -1 && forwardable < max_samples)
+				max_samples = forwardable;
+			#if SDF_SAMPLINGRATE_ALLOCATION
+				// childs without reported demand are not limited by their demand,
+				// motes of subtree not covered by reported demands are attributed to them
+				static samplingrate_demand current[SDF_SAMPLINGRATE_ALLOCATION_CHILDS];
+				int i, count = demands_current(current), motes = samplingrate_childs();
+				for(i = 0; i < count; i++)
+					motes -= current[i].motes;
+				int unreported = udphelper_childs_direct_count() - count;
+				for(i = 0; i < unreported && count < SDF_SAMPLINGRATE_ALLOCATION_CHILDS; i++, count++) {
+					current[count].samplingrate = CONTROL_SAMPLINGRATE_MAX;
+					current[count].motes        = (motes > unreported) ? (motes + unreported - 1) / unreported : 1;
+				}
+
+				// achievable samplingrate is reported to parent (never more than its budget can forward)
+				samplingrate = samplingrate_allocate(max_samples, current, count, &demand);
+				if(forwardable != -1 && demand > forwardable)
+					demand = forwardable;
+				samplingrate_limit_childs = samplingrate;
+				if(!udphelper_parent_is_sink())
+					ctimer_set(&backofftimer_send_demand, CLOCK_SECOND / 4, send_demand, NULL);
+			#else
+				samplingrate = samplingrate_calculate(max_samples);
+				samplingrate_limit_childs = samplingrate;
+			#endif
+			samplingrate_epoch++;
 
 			// send sampling rate to all childs
 			if(udphelper_childs_direct_count() > 0) {
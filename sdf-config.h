@@ -34,11 +34,42 @@
  */
 #define BATTERY_INITIALCAPACITY 70
 
+/**
+ * distribute daily energy by hourly harvest profile instead of equally over the day
+ *
+ * (needs CONSUMPTIONRATE_SOLARENERGY_BATTERYPREDICTION 0)
+ */
+#define CONSUMPTIONRATE_PROFILE 0
+
+/**
+ * battery level in percent reserved for the night (CONSUMPTIONRATE_PROFILE)
+ *
+ * hours with more harvest follow the harvest profile as long as the battery above the reserve
+ * holds the energy the night needs, otherwise they save the missing part. Hours with less
+ * harvest get the equal share, below the reserve blended linearly towards the harvest profile.
+ * (below SDF_SAMPLINGRATE_BATTERY_TARGET, so the headroom up to the target is spent by day)
+ */
+#define CONSUMPTIONRATE_PROFILE_RESERVE 50
+
 /**
  * number of samples saved of energy neutral consumption rate
  */
 #define CONSUMPTIONRATE_SAMPLES 14
 
+/**
+ * forecaster of daily harvested energy used for consumption rate
+ *
+ * CONSUMPTIONRATE_FORECASTER_QUANTILE: quantile of last CONSUMPTIONRATE_SAMPLES days
+ * CONSUMPTIONRATE_FORECASTER_EWMA:     exponentially weighted average and variance
+ * CONSUMPTIONRATE_FORECASTER_SEASONAL: day of year trend of last CONSUMPTIONRATE_SAMPLES days
+ */
+#define CONSUMPTIONRATE_FORECASTER CONSUMPTIONRATE_FORECASTER_QUANTILE
+
+/**
+ * weight of newest sample for CONSUMPTIONRATE_FORECASTER_EWMA (fpint: 0.25)
+ */
+#define CONSUMPTIONRATE_FORECASTER_EWMA_WEIGHT 0x4000
+
 /**
  * whether solar harvested energy should be predicted by battery difference
  * or polling of solarpanel
@@ -50,11 +81,42 @@
  */
 #define DRANDOM_SEED 12345
 
+/**
+ * maximum interval in (real) seconds between two energy ledger updates
+ *
+ * (the ledger is updated on read, energest overflows every 36 hours on tmote sky)
+ */
+#define ENERGYLEDGER_WATCHDOGINTERVAL 43200
+
+/**
+ * number of steps of quarter sine wave table for fpint_sin() and fpint_cos()
+ *
+ * (16, 32, 64, 128 or 256: table needs 2 bytes ROM per step)
+ */
+#define FPINT_SIN_TABLESIZE 64
+
 /**
  * port for SDF udp communication
  */
 #define SDF_PORT 5678
 
+/**
+ * motes send samples to their parent which merges them with its own samples
+ * into messages of SDF_SAMPLINGRATE_BATCH samples, instead of sending samples
+ * directly to the sink
+ *
+ * (samples are not summarized: only incomplete batches are merged, so at most
+ * one message per mote and interval is saved on every hop)
+ */
+#define SDF_AGGREGATION 0
+
+/**
+ * number of samples of childs a mote buffers for aggregation in addition to a batch (SDF_AGGREGATION)
+ *
+ * (at least SDF_SAMPLINGRATE_BATCH: a full buffer is sent before it could drop samples of childs)
+ */
+#define SDF_AGGREGATION_SAMPLES 8
+
 /**
  * initialization phase of SDF with minimum sampling
  */
@@ -70,11 +132,64 @@
  */
 #define SDF_SAMPLINGRATE_UPDATEINTERVAL 600
 
+/**
+ * send samplingrate to childs with a single link-local multicast instead of unicasting it to every child
+ *
+ * (childs having missed it request it from their parent)
+ */
+#define SDF_SAMPLINGRATE_MULTICAST 0
+
 /**
  * number of drain samples to keep for calculation of Ptx, Prx and Psense
  */
 #define SDF_SAMPLINGRATE_ENERGYSAMPLES 10
 
+/**
+ * number of samples sent in a single message (1 disables batching)
+ *
+ * (a message with more than 4 samples will not fit into a single 802.15.4 frame)
+ */
+#define SDF_SAMPLINGRATE_BATCH 4
+
+/**
+ * childs report their achievable sampling rate and the motes of their subtree to their
+ * parent, which limits them to a max-min fair share of its energy instead of an equal share
+ */
+#define SDF_SAMPLINGRATE_ALLOCATION 0
+
+/**
+ * maximum number of direct childs whose demands are regarded (SDF_SAMPLINGRATE_ALLOCATION)
+ */
+#define SDF_SAMPLINGRATE_ALLOCATION_CHILDS 8
+
+/**
+ * controller of sampling rate
+ *
+ * SDF_SAMPLINGRATE_CONTROLLER_NEUTRAL: spend predicted energy neutral consumption rate
+ * SDF_SAMPLINGRATE_CONTROLLER_BATTERY: energy neutral consumption rate corrected towards battery target level
+ */
+#define SDF_SAMPLINGRATE_CONTROLLER SDF_SAMPLINGRATE_CONTROLLER_NEUTRAL
+
+/**
+ * battery level in percent the SDF_SAMPLINGRATE_CONTROLLER_BATTERY is heading for
+ */
+#define SDF_SAMPLINGRATE_BATTERY_TARGET 70
+
+/**
+ * battery level in percent below only minimal sampling rate is used (SDF_SAMPLINGRATE_CONTROLLER_BATTERY)
+ */
+#define SDF_SAMPLINGRATE_BATTERY_FLOOR 10
+
+/**
+ * proportional gain of SDF_SAMPLINGRATE_CONTROLLER_BATTERY (fpint: 1/144, difference to target spent within a day)
+ */
+#define SDF_SAMPLINGRATE_BATTERY_KP 0x01C7
+
+/**
+ * integral gain of SDF_SAMPLINGRATE_CONTROLLER_BATTERY (fpint: 1/20736)
+ */
+#define SDF_SAMPLINGRATE_BATTERY_KI 0x0003
+
 /**
  * emulate solarpanel
  */
@@ -87,6 +202,32 @@
  */
 #define SOLARPANEL_SIMPLECALCULATION 1
 
+/**
+ * solar radiation by table lookup for every day of year
+ *
+ * (table is generated at compile time, overrides SOLARPANEL_SIMPLECALCULATION)
+ */
+#define SOLARPANEL_TABLE 1
+
+/**
+ * days between two rows of the solar radiation table
+ *
+ * (table needs 2 bytes ROM per value: 47 rows for 8 days)
+ */
+#define SOLARPANEL_TABLE_DAYS 8
+
+/**
+ * minutes between two columns of the solar radiation table (divisor of 720)
+ *
+ * (table needs 2 bytes ROM per value: 37 columns for 20 minutes)
+ */
+#define SOLARPANEL_TABLE_MINUTES 20
+
+/**
+ * latitude of solarpanel in degrees (Darmstadt)
+ */
+#define SOLARPANEL_LATITUDE 49.878667
+
 /**
  * voltage of solarpanel
  */
@@ -117,4 +258,9 @@
  */
 #define TIME_MINUTE 0
 
+/**
+ * seconds between checks of rpl preferred parent for notifying parent changes
+ */
+#define UDPHELPER_PARENTINTERVAL 5
+
 #endif /* SDFCONFIG_H_ */
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "contiki.h"
+
+#include "sdf-config.h"
+#include "consumptionrate.h"
+#include "fpint.h"
+
+/**
+ * Replay harness for the harvest forecasters of consumptionrate (host only)
+ *
+ *   ./sdf-forecast.host              scores all forecasters on a synthetic year
+ *   ./sdf-forecast.host trace        scores all forecasters on a recorded trace
+ *   ./sdf-forecast.host -synthetic   prints the synthetic year as trace
+ *
+ * A trace has a line "day harvest" for every day: day of year and harvested mAh.
+ * Every forecaster forecasts each day before it learns the harvest of that day,
+ * the first CONSUMPTIONRATE_SAMPLES days are not scored.
+ */
+#if !CONTIKI_TARGET_HOST
+	#error sdf-forecast is a host program (make sdf-forecast TARGET=host)
+#endif
+
+/**
+ * maximum number of days of a trace
+ */
+#define TRACE_DAYS 3650
+
+/**
+ * forecasters to score
+ */
+static const consumptionrate_forecaster* const forecasters[] = {
+	&consumptionrate_forecaster_quantile,
+	&consumptionrate_forecaster_ewma,
+	&consumptionrate_forecaster_seasonal,
+};
+#define FORECASTERS (sizeof(forecasters) / sizeof(forecasters[0]))
+
+/**
+ * replayed trace
+ */
+static unsigned int trace_day[TRACE_DAYS];
+static double trace_harvest[TRACE_DAYS];
+static int trace_days = 0;
+
+/**
+ * synthetic year starting at TIME_DAY: seasonal clear sky harvest with
+ * weather periods (cloudiness correlated over several days)
+ */
+static void trace_synthetic() {
+	double cloudiness = 0.0;
+	srand(DRANDOM_SEED);
+
+	for(trace_days = 0; trace_days < 365; trace_days++) {
+		unsigned int day = (TIME_DAY + trace_days) % 365;
+		double clearsky = 65.0 + 45.0 * sin(2.0 * M_PI * ((double) day - 80.0) / 365.0);
+
+		double noise = (double) rand() / RAND_MAX - 0.5;
+		cloudiness = 0.7 * cloudiness + 0.6 * noise;
+		double factor = fmin(1.0, fmax(0.15, 0.75 - cloudiness));
+
+		trace_day[trace_days]     = day;
+		trace_harvest[trace_days] = clearsky * factor;
+	}
+}
+
+/**
+ * reads a recorded trace
+ */
+static void trace_read(const char* filename) {
+	FILE* file = fopen(filename, "r");
+	if(file == NULL) {
+		printf("can not open trace %s\n", filename);
+		return;
+	}
+
+	char line[128];
+	while(trace_days < TRACE_DAYS && fgets(line, sizeof(line), file) != NULL) {
+		unsigned int day;
+		double harvest;
+		if(line[0] != '#' && sscanf(line, "%u %lf", &day, &harvest) == 2) {
+			trace_day[trace_days]     = day % 365;
+			trace_harvest[trace_days] = harvest;
+			trace_days++;
+		}
+	}
+	fclose(file);
+}
+
+/**
+ * replays trace to a forecaster and prints its prediction error
+ */
+static void score(const consumptionrate_forecaster* forecaster) {
+	double error = 0.0, bias = 0.0, used = 0.0, harvested = 0.0;
+	int overestimated = 0, scored = 0, i;
+
+	forecaster->reset();
+	for(i = 0; i < trace_days; i++) {
+		double forecast = forecaster->forecast(trace_day[i]) / 65536.0;
+
+		if(i >= CONSUMPTIONRATE_SAMPLES) {
+			error     += fabs(forecast - trace_harvest[i]);
+			bias      += forecast - trace_harvest[i];
+			used      += fmin(fmax(forecast, 0.0), trace_harvest[i]);
+			harvested += trace_harvest[i];
+			overestimated += (forecast > trace_harvest[i]);
+			scored++;
+		}
+
+		forecaster->update((fpint) lround(trace_harvest[i] * 65536.0), trace_day[i]);
+	}
+
+	if(scored == 0)
+		return;
+
+	printf("%-10s %4d days  %8.2fmAh  %+8.2fmAh  %9.1f%%  %9.1f%%\n", forecaster->name, scored,
+		error / scored, bias / scored, 100.0 * overestimated / scored, 100.0 * used / harvested);
+}
+
+PROCESS(sdf_forecast_process, "SDF-Forecast");
+AUTOSTART_PROCESSES(&sdf_forecast_process);
+
+PROCESS_THREAD(sdf_forecast_process, ev, data) {
+	PROCESS_BEGIN();
+
+	// print synthetic trace
+	if(host_argc > 1 && strcmp(host_argv[1], "-synthetic") == 0) {
+		trace_synthetic();
+
+		int i;
+		printf("# day harvest[mAh]\n");
+		for(i = 0; i < trace_days; i++)
+			printf("%u %.3f\n", trace_day[i], trace_harvest[i]);
+	}
+
+	// score forecasters
+	else {
+		if(host_argc > 1)
+			trace_read(host_argv[1]);
+		else
+			trace_synthetic();
+
+		printf("forecaster   scored  abs. error        bias  overestimated  used harvest\n");
+		unsigned int i;
+		for(i = 0; i < FORECASTERS && trace_days > 0; i++)
+			score(forecasters[i]);
+	}
+
+	PROCESS_END();
+}
@@ -10,6 +10,7 @@
 #include "co2-sensor.h"
 #include "gps-sensor.h"
 #include "udphelper.h"
+#include "sample.h"
 
 // udp socket
 static struct uip_udp_conn* udp;
@@ -47,10 +48,25 @@ PROCESS_THREAD(sdfserver, ev, data) {
         // new UDP data
         if(ev == tcpip_event && uip_newdata()) {
 			#if PRINTSAMPLES
-				printf("received '%s' from ", (char*) udphelper_packet_data());
 				static uip_ipaddr_t sender;
-				udphelper_print_address(udphelper_packet_senderaddress(&sender));
-				printf("\n");
+				udphelper_packet_senderaddress(&sender);
+
+				static sample s;
+				int i, count = sample_count(udphelper_packet_data(), udphelper_packet_datalen());
+				if(count == 0) {
+					printf("received invalid sample from ");
+					udphelper_print_address(&sender);
+					printf("\n");
+				}
+				for(i = 0; i < count; i++) {
+					sample_decode(&s, udphelper_packet_data(), i);
+					printf("received #%u of node %x co=%uppm co2=%uppm ", s.sequence, s.node, s.co, s.co2);
+					printf("lat=%s ", fpint_str(s.latitude, fpint_strbuf));
+					printf("lon=%s ", fpint_str(s.longitude, fpint_strbuf));
+					printf("battery=%u%% via ", s.battery);
+					udphelper_print_address(&sender);
+					printf("\n");
+				}
 			#endif
         }
     }
@@ -0,0 +1,114 @@
+/**
+ * generates the solar irradiance table used by solarpanel.c (SOLARPANEL_TABLE)
+ *
+ *   gcc -iquote . -o tools/solarpanel-table tools/solarpanel-table.c -lm
+ *   ./tools/solarpanel-table > SDF/solarpanel-table.h
+ *
+ * (run by the Makefile on the build host whenever sdf-config.h changes)
+ *
+ * The table contains the current in mA of the configured solarpanel calculated by
+ * the brock formula for every SOLARPANEL_TABLE_DAYS days of the year and every
+ * SOLARPANEL_TABLE_MINUTES minutes up to noon (afternoon is symmetric). The maximum
+ * error of the runtime interpolation is printed to stderr.
+ */
+#include <stdio.h>
+#include <math.h>
+
+#include "sdf-config.h"
+
+#if 720 % SOLARPANEL_TABLE_MINUTES != 0
+	#error SOLARPANEL_TABLE_MINUTES has to be a divisor of 720
+#endif
+
+/**
+ * rows for all days of year (last row is first day of next year for interpolation)
+ */
+#define ROWS (364 / SOLARPANEL_TABLE_DAYS + 2)
+
+/**
+ * columns for all minutes until noon
+ */
+#define COLUMNS (720 / SOLARPANEL_TABLE_MINUTES + 1)
+
+/**
+ * current of solarpanel in mA by brock formula (see energy_brock() in solarpanel.c)
+ *
+ * "Calculatingsolar radiation for ecological studies"
+ * Ecological Modelling, vol. 14, no. 1-2, pp. 1-19, 1981
+ */
+static double current(double day, double minute) {
+	double lat = SOLARPANEL_LATITUDE * M_PI / 180.0;
+
+	// radius vector, declination and minute angle
+	double rv = 1.0 / (1.0 + 0.033 * cos(2.0 * M_PI * day / 365.0));
+	double d  = 0.4093 * sin(2.0 * M_PI * (day + 284.0) / 365.0);
+	double ma = (minute - 720.0) * M_PI / 720.0;
+
+	// solar radiation in W/m^2
+	double cosza = sin(d) * sin(lat) + cos(d) * cos(lat) * cos(ma);
+	double sr = 1353.0 / (rv * rv) * cosza;
+	if(sr < 0.0)
+		return 0.0;
+
+	// scale to solarpanel size and efficiency, convert Watt to Milliampere
+	return sr * (SOLARPANEL_SIZE / 10000.0) * (SOLARPANEL_EFFICIENCY / 100.0) / SOLARPANEL_VOLT * 1000.0;
+}
+
+int main() {
+	static unsigned short table[ROWS][COLUMNS];
+	int row, column, day, minute;
+
+	// shift of table values (as fpint) to fit into 16 bit
+	double max = 0.0;
+	for(row = 0; row < ROWS; row++)
+		for(column = 0; column < COLUMNS; column++)
+			max = fmax(max, current(row * SOLARPANEL_TABLE_DAYS, column * SOLARPANEL_TABLE_MINUTES));
+	int shift = 0;
+	while(max * 65536.0 / (1 << shift) > 65535.0)
+		shift++;
+
+	for(row = 0; row < ROWS; row++)
+		for(column = 0; column < COLUMNS; column++)
+			table[row][column] = (unsigned short) lround(current(row * SOLARPANEL_TABLE_DAYS, column * SOLARPANEL_TABLE_MINUTES) * 65536.0 / (1 << shift));
+
+	// maximum error of bilinear interpolation for every minute of the year
+	double error = 0.0;
+	for(day = 0; day < 365; day++) {
+		for(minute = 0; minute <= 720; minute++) {
+			row    = day / SOLARPANEL_TABLE_DAYS;
+			column = minute / SOLARPANEL_TABLE_MINUTES;
+			int next = (column + 1 < COLUMNS) ? column + 1 : column;
+			double fd = (double) (day - row * SOLARPANEL_TABLE_DAYS) / SOLARPANEL_TABLE_DAYS;
+			double fm = (double) (minute - column * SOLARPANEL_TABLE_MINUTES) / SOLARPANEL_TABLE_MINUTES;
+			double a = table[row][column]     + (table[row][next]     - table[row][column])     * fm;
+			double b = table[row + 1][column] + (table[row + 1][next] - table[row + 1][column]) * fm;
+			double interpolated = (a + (b - a) * fd) * (1 << shift) / 65536.0;
+			error = fmax(error, fabs(interpolated - current(day, minute)));
+		}
+	}
+	fprintf(stderr, "solarpanel table: %dx%d values (%d bytes), max current %.3fmA, max interpolation error %.4fmA\n",
+		ROWS, COLUMNS, (int) sizeof(table), max, error);
+
+	printf("#ifndef SOLARPANEL_TABLE_H_\n");
+	printf("#define SOLARPANEL_TABLE_H_\n\n");
+	printf("/**\n");
+	printf(" * solarpanel current in mA by day and minute (generated by tools/solarpanel-table.c, do not edit)\n");
+	printf(" *\n");
+	printf(" * latitude %f, %dcm^2, %d%% efficiency, %dV\n", SOLARPANEL_LATITUDE, SOLARPANEL_SIZE, SOLARPANEL_EFFICIENCY, SOLARPANEL_VOLT);
+	printf(" * (table values are fpint values shifted right by SOLARPANEL_TABLE_SHIFT)\n");
+	printf(" */\n");
+	printf("#define SOLARPANEL_TABLE_ROWS %d\n", ROWS);
+	printf("#define SOLARPANEL_TABLE_COLUMNS %d\n", COLUMNS);
+	printf("#define SOLARPANEL_TABLE_SHIFT %d\n\n", shift);
+	printf("static const unsigned short solarpanel_table[SOLARPANEL_TABLE_ROWS][SOLARPANEL_TABLE_COLUMNS] = {\n");
+	for(row = 0; row < ROWS; row++) {
+		printf("\t{");
+		for(column = 0; column < COLUMNS; column++)
+			printf((column == 0) ? "0x%04X" : ", 0x%04X", table[row][column]);
+		printf((row + 1 < ROWS) ? "}, // day %d\n" : "}  // day %d\n", row * SOLARPANEL_TABLE_DAYS);
+	}
+	printf("};\n\n");
+	printf("#endif /* SOLARPANEL_TABLE_H_ */\n");
+
+	return 0;
+}